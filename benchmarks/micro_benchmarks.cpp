@@ -0,0 +1,270 @@
+#include "game_logic.hpp"
+#include "linear_system_solver.hpp"
+#include "solver.hpp"
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Microbenchmarks of the board and linear system kernels.
+//
+// Every kernel runs on the same fixtures: seeded random boards over a sweep of
+// sizes and mine densities, and every board in text_minefields/ together with
+// any board files passed on the command line. The system kernels run on the
+// board with seeded openings revealed until about a third of its safe cells
+// show, which is a typical state in the middle of a solve.
+
+namespace {
+
+constexpr unsigned fixture_seed = 20240601;
+
+struct Fixture {
+  std::string name;
+  int mines_count = 0;
+  Board board;  ///< The board with nothing revealed.
+  int start_idx = -1; ///< Padded index of the first zero cell, -1 if there is none.
+  Board opened; ///< The board with about a third of its safe cells revealed.
+  SparseSystem system; ///< The equations of opened.
+  std::vector<std::vector<int>> matrix; ///< The augmented matrix of system.
+  std::vector<std::vector<int>> reduced; ///< matrix after dense elimination.
+  BitsetMatrix bitset;                   ///< The bitset matrix of system.
+  BitsetMatrix bitset_reduced;           ///< bitset after bitset elimination.
+};
+
+std::shared_ptr<Fixture> make_fixture(std::string name, const Board &board,
+                                      int mines_count) {
+  auto fixture = std::make_shared<Fixture>();
+  fixture->name = std::move(name);
+  fixture->mines_count = mines_count;
+  fixture->board = board;
+  fixture->opened = board;
+
+  std::vector<int> zero_cells;
+  for (int row = 0; row < board.height(); row++) {
+    for (int col = 0; col < board.width(); col++) {
+      const Cell &cell = board.at(row, col);
+      if (not cell.is_mine && cell.adjacent_mines == 0) {
+        zero_cells.push_back(board.index(row, col));
+      }
+    }
+  }
+
+  if (not zero_cells.empty()) {
+    fixture->start_idx = zero_cells.front();
+  }
+
+  // Open zero cells in a seeded order until a third of the safe cells show
+  Rng rng(fixture_seed);
+  rng.shuffle(zero_cells.begin(), zero_cells.end());
+  int safe_cells = board.cell_count() - mines_count;
+  int revealed_cells = 0;
+  std::vector<int> revealed;
+  for (int idx : zero_cells) {
+    if (revealed_cells * 3 >= safe_cells) {
+      break;
+    }
+    if (not fixture->opened[idx].is_revealed) {
+      reveal_cell(fixture->opened, board.row_of(idx), board.col_of(idx),
+                  revealed);
+      revealed_cells += revealed.size();
+    }
+  }
+
+  Solver solver(EliminationBackend::dense, false);
+  fixture->system =
+      solver.generate_linear_equations(fixture->opened, mines_count);
+  fixture->matrix = create_augmented_matrix(fixture->system);
+  fixture->reduced = fixture->matrix;
+  gaussian_elimination(fixture->reduced, fixture->system.num_variables());
+  fixture->bitset = create_bitset_matrix(fixture->system);
+  fixture->bitset_reduced = fixture->bitset;
+  gaussian_elimination(fixture->bitset_reduced,
+                       fixture->system.num_variables());
+  return fixture;
+}
+
+void set_counters(benchmark::State &state, const Fixture &fixture) {
+  state.counters["cells"] = fixture.board.cell_count();
+  state.counters["vars"] = fixture.system.num_variables();
+  state.counters["rows"] = fixture.system.num_equations();
+}
+
+void register_kernels(const std::shared_ptr<Fixture> &fixture) {
+  const std::string &name = fixture->name;
+
+  benchmark::RegisterBenchmark(
+      ("generate_board/" + name).c_str(), [fixture](benchmark::State &state) {
+        Rng rng(fixture_seed);
+        for (auto _ : state) {
+          Board board =
+              generate_board(fixture->mines_count, fixture->board.height(),
+                             fixture->board.width(), rng);
+          benchmark::DoNotOptimize(board);
+        }
+        set_counters(state, *fixture);
+      });
+
+  benchmark::RegisterBenchmark(
+      ("count_adjacent_mines/" + name).c_str(),
+      [fixture](benchmark::State &state) {
+        Board board = fixture->board;
+        for (auto _ : state) {
+          count_adjacent_mines(board);
+          benchmark::DoNotOptimize(board);
+        }
+        set_counters(state, *fixture);
+      });
+
+  if (fixture->start_idx >= 0) {
+    benchmark::RegisterBenchmark(
+        ("reveal_cell/" + name).c_str(), [fixture](benchmark::State &state) {
+          int row = fixture->board.row_of(fixture->start_idx);
+          int col = fixture->board.col_of(fixture->start_idx);
+          std::vector<int> revealed;
+          for (auto _ : state) {
+            state.PauseTiming();
+            Board board = fixture->board;
+            state.ResumeTiming();
+            benchmark::DoNotOptimize(reveal_cell(board, row, col, revealed));
+          }
+          state.counters["revealed"] = revealed.size();
+          set_counters(state, *fixture);
+        });
+  }
+
+  benchmark::RegisterBenchmark(
+      ("generate_linear_equations/" + name).c_str(),
+      [fixture](benchmark::State &state) {
+        Solver solver(EliminationBackend::dense, false);
+        Board board = fixture->opened;
+        for (auto _ : state) {
+          SparseSystem system =
+              solver.generate_linear_equations(board, fixture->mines_count);
+          benchmark::DoNotOptimize(system);
+        }
+        set_counters(state, *fixture);
+      });
+
+  benchmark::RegisterBenchmark(
+      ("create_augmented_matrix/" + name).c_str(), [fixture](benchmark::State &state) {
+        for (auto _ : state) {
+          auto matrix = create_augmented_matrix(fixture->system);
+          benchmark::DoNotOptimize(matrix);
+        }
+        set_counters(state, *fixture);
+      });
+
+  benchmark::RegisterBenchmark(
+      ("gaussian_elimination/" + name).c_str(), [fixture](benchmark::State &state) {
+        for (auto _ : state) {
+          state.PauseTiming();
+          auto matrix = fixture->matrix;
+          state.ResumeTiming();
+          gaussian_elimination(matrix, fixture->system.num_variables());
+          benchmark::DoNotOptimize(matrix);
+        }
+        set_counters(state, *fixture);
+      });
+
+  benchmark::RegisterBenchmark(
+      ("deduce_variables/" + name).c_str(), [fixture](benchmark::State &state) {
+        for (auto _ : state) {
+          auto deduced = deduce_variables(fixture->reduced,
+                                          fixture->system.num_variables());
+          benchmark::DoNotOptimize(deduced);
+        }
+        set_counters(state, *fixture);
+      });
+
+  benchmark::RegisterBenchmark(
+      ("create_bitset_matrix/" + name).c_str(), [fixture](benchmark::State &state) {
+        for (auto _ : state) {
+          BitsetMatrix matrix = create_bitset_matrix(fixture->system);
+          benchmark::DoNotOptimize(matrix);
+        }
+        set_counters(state, *fixture);
+      });
+
+  benchmark::RegisterBenchmark(
+      ("bitset_elimination/" + name).c_str(), [fixture](benchmark::State &state) {
+        for (auto _ : state) {
+          state.PauseTiming();
+          BitsetMatrix matrix = fixture->bitset;
+          state.ResumeTiming();
+          gaussian_elimination(matrix, fixture->system.num_variables());
+          benchmark::DoNotOptimize(matrix);
+        }
+        set_counters(state, *fixture);
+      });
+
+  benchmark::RegisterBenchmark(
+      ("bitset_deduce_variables/" + name).c_str(), [fixture](benchmark::State &state) {
+        for (auto _ : state) {
+          auto deduced = deduce_variables(fixture->bitset_reduced,
+                                          fixture->system.num_variables());
+          benchmark::DoNotOptimize(deduced);
+        }
+        set_counters(state, *fixture);
+      });
+}
+
+void register_generated_fixtures() {
+  struct Size {
+    int width;
+    int height;
+  };
+  const Size sizes[] = {{9, 9}, {16, 16}, {30, 16}, {50, 50}};
+  const int densities_percent[] = {12, 16, 20};
+
+  Rng rng(fixture_seed);
+  for (Size size : sizes) {
+    for (int density : densities_percent) {
+      int mines_count = size.width * size.height * density / 100;
+      Board board = generate_board(mines_count, size.height, size.width, rng);
+      register_kernels(make_fixture(std::to_string(size.width) + "x" +
+                                        std::to_string(size.height) + "_d" +
+                                        std::to_string(density),
+                                    board, mines_count));
+    }
+  }
+}
+
+void register_file_fixture(const std::filesystem::path &path) {
+  try {
+    auto [board, mines_count] = read_board_from_file(path.string());
+    register_kernels(make_fixture(path.stem().string(), board, mines_count));
+  } catch (const std::exception &error) {
+    std::cerr << "skipping " << path << ": " << error.what() << std::endl;
+  }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  benchmark::Initialize(&argc, argv);
+
+  register_generated_fixtures();
+
+#ifdef CJMINES_TEXT_MINEFIELDS_DIR
+  std::filesystem::path minefields(CJMINES_TEXT_MINEFIELDS_DIR);
+  if (std::filesystem::is_directory(minefields)) {
+    for (const auto &entry : std::filesystem::directory_iterator(minefields)) {
+      if (entry.path().extension() == ".txt") {
+        register_file_fixture(entry.path());
+      }
+    }
+  }
+#endif
+
+  // Arguments left after the benchmark flags are extra board files
+  for (int i = 1; i < argc; i++) {
+    register_file_fixture(argv[i]);
+  }
+
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
@@ -0,0 +1,12 @@
+#include "allocation_counter.hpp"
+
+// Constant initialized, so it is null before any dynamic initializer runs
+static long (*installed_counter)() = nullptr;
+
+long thread_allocation_count() {
+  return installed_counter ? installed_counter() : 0;
+}
+
+bool allocation_counting_available() { return installed_counter != nullptr; }
+
+void install_allocation_counter(long (*count)()) { installed_counter = count; }
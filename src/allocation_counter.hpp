@@ -0,0 +1,29 @@
+#ifndef ALLOCATION_COUNTER_HPP
+#define ALLOCATION_COUNTER_HPP
+
+/**
+ * @brief Number of times operator new has run on the calling thread.
+ *
+ * cjmines_core leaves operator new alone. A program which wants allocations
+ * counted compiles allocation_counting.cpp into itself, which replaces the
+ * global operator new and delete with ones that count each allocation in a
+ * thread local and otherwise forward to malloc and free. Comparing two
+ * readings then gives the allocations made in between.
+ *
+ * @return The count, always 0 unless allocation_counting_available().
+ */
+long thread_allocation_count();
+
+/**
+ * @brief Whether the program counts its allocations, see
+ * thread_allocation_count().
+ */
+bool allocation_counting_available();
+
+/**
+ * @brief Makes thread_allocation_count() read count, called once before main
+ * by allocation_counting.cpp.
+ */
+void install_allocation_counter(long (*count)());
+
+#endif // ALLOCATION_COUNTER_HPP
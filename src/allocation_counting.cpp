@@ -0,0 +1,42 @@
+#include "allocation_counter.hpp"
+#include <cstdlib>
+#include <new>
+
+// Replaces the global operator new and delete of the program it is compiled
+// into, see thread_allocation_count(). Only the bench and test programs that
+// ask for it link this, never cjmines_core itself.
+
+static thread_local long allocations = 0;
+
+static long count_allocations() { return allocations; }
+
+[[maybe_unused]] static const bool installed =
+    (install_allocation_counter(&count_allocations), true);
+
+void *operator new(std::size_t size) {
+  allocations++;
+  if (void *memory = std::malloc(size == 0 ? 1 : size)) {
+    return memory;
+  }
+  throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment) {
+  allocations++;
+  auto align = static_cast<std::size_t>(alignment);
+  // aligned_alloc needs a size that is a multiple of the alignment
+  std::size_t rounded = (size + align - 1) / align * align;
+  if (void *memory = std::aligned_alloc(align, rounded == 0 ? align : rounded)) {
+    return memory;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept { std::free(memory); }
+void operator delete(void *memory, std::size_t) noexcept { std::free(memory); }
+void operator delete(void *memory, std::align_val_t) noexcept {
+  std::free(memory);
+}
+void operator delete(void *memory, std::size_t, std::align_val_t) noexcept {
+  std::free(memory);
+}
@@ -0,0 +1,240 @@
+#include "bench.hpp"
+#include "board_archive.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <sys/resource.h>
+#include <vector>
+
+std::optional<EliminationBackend> parse_backend(const std::string &name) {
+  // dense_float names the dense backend from before it reduced exactly
+  if (name == "dense" || name == "dense_float") {
+    return EliminationBackend::dense;
+  } else if (name == "bitset") {
+    return EliminationBackend::bitset;
+  } else if (name == "incremental") {
+    return EliminationBackend::incremental;
+  }
+  return std::nullopt;
+}
+
+std::string backend_name(EliminationBackend backend) {
+  switch (backend) {
+  case EliminationBackend::dense:
+    return "dense";
+  case EliminationBackend::bitset:
+    return "bitset";
+  case EliminationBackend::incremental:
+    return "incremental";
+  }
+  return "unknown";
+}
+
+// Nearest rank percentile of sorted, non-empty values
+static double percentile(const std::vector<double> &sorted, double p) {
+  int rank = static_cast<int>(std::ceil(p / 100.0 * sorted.size()));
+  return sorted[std::clamp(rank - 1, 0, static_cast<int>(sorted.size()) - 1)];
+}
+
+// Peak resident set size of the process, in kilobytes on Linux
+static long peak_memory_kb() {
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+int run_bench(const BenchOptions &options, int width, int height,
+              int mines_count, const std::string &file_path, int jobs,
+              std::uint64_t seed) {
+  // An archive is streamed through, starting over when it runs out
+  std::optional<BoardArchive> archive;
+  BoardArchive::iterator next_record;
+  Board file_board;
+  if (not file_path.empty() && is_board_archive(file_path)) {
+    archive.emplace(file_path);
+    if (archive->size() == 0) {
+      std::cerr << "File does not contain a board" << std::endl;
+      return 1;
+    }
+    next_record = archive->begin();
+    BoardRecord first = *next_record;
+    width = first.width;
+    height = first.height;
+    mines_count = first.mine_count;
+  } else if (not file_path.empty()) {
+    auto [board, mines] = read_board_from_file(file_path);
+    file_board = board;
+    width = board.width();
+    height = board.height();
+    mines_count = mines;
+  }
+
+  Rng rng(seed);
+  Solver solver(options.backend, false, jobs, rng());
+  std::ofstream profile_file;
+  if (not options.profile_path.empty()) {
+    profile_file.open(options.profile_path);
+    if (!profile_file.is_open()) {
+      std::cerr << "Failed to open profile file" << std::endl;
+      return 1;
+    }
+    solver.set_profiling(true);
+  }
+  std::vector<double> latencies_ms;
+  latencies_ms.reserve(options.boards);
+  int solved = 0;
+
+  // An archive may hold boards of several sizes, the report then says so
+  const int first_width = width;
+  const int first_height = height;
+  const int first_mines = mines_count;
+  bool mixed_size = false;
+  bool mixed_mines = false;
+
+  auto bench_start = std::chrono::steady_clock::now();
+
+  std::vector<Board> batch;
+  auto solve_batch = [&] {
+    auto solve_start = std::chrono::steady_clock::now();
+    for (const auto &start : solver.solve_batch(batch)) {
+      solved += start.has_value();
+    }
+    auto solve_end = std::chrono::steady_clock::now();
+
+    double batch_ms =
+        std::chrono::duration<double, std::milli>(solve_end - solve_start)
+            .count();
+    latencies_ms.insert(latencies_ms.end(), batch.size(),
+                        batch_ms / batch.size());
+    if (profile_file.is_open()) {
+      profile_file << solver.profile().to_json() << '\n';
+    }
+    batch.clear();
+  };
+
+  for (int i = 0; i < options.boards; i++) {
+    Board board;
+    if (archive.has_value()) {
+      if (next_record == archive->end()) {
+        next_record = archive->begin();
+      }
+      BoardRecord record = *next_record++;
+      board = record.to_board();
+      mines_count = record.mine_count;
+      mixed_size |=
+          record.width != first_width || record.height != first_height;
+      mixed_mines |= mines_count != first_mines;
+    } else {
+      board = file_path.empty()
+                  ? generate_board(mines_count, height, width, rng)
+                  : file_board;
+    }
+
+    if (options.batch > 1) {
+      // solve_batch() only takes boards of one size, a new size starts a
+      // new batch
+      if (!batch.empty() && (batch.front().width() != board.width() ||
+                             batch.front().height() != board.height())) {
+        solve_batch();
+      }
+      batch.push_back(std::move(board));
+      if (static_cast<int>(batch.size()) == options.batch ||
+          i + 1 == options.boards) {
+        solve_batch();
+      }
+      continue;
+    }
+
+    auto solve_start = std::chrono::steady_clock::now();
+    bool is_ng = solver.solve(board, mines_count).has_value();
+    auto solve_end = std::chrono::steady_clock::now();
+
+    solved += is_ng;
+    if (profile_file.is_open()) {
+      profile_file << solver.profile().to_json() << '\n';
+    }
+    latencies_ms.push_back(
+        std::chrono::duration<double, std::milli>(solve_end - solve_start)
+            .count());
+  }
+
+  auto bench_end = std::chrono::steady_clock::now();
+  double total_seconds =
+      std::chrono::duration<double>(bench_end - bench_start).count();
+
+  std::sort(latencies_ms.begin(), latencies_ms.end());
+  if (latencies_ms.empty()) {
+    latencies_ms.push_back(0);
+  }
+
+  double boards_per_second =
+      total_seconds > 0 ? options.boards / total_seconds : 0;
+  double success_rate =
+      options.boards > 0 ? static_cast<double>(solved) / options.boards : 0;
+
+  // name, value pairs shared by both output formats
+  std::vector<std::pair<std::string, std::string>> fields;
+  auto add = [&](const std::string &name, auto value) {
+    std::ostringstream out;
+    out << std::setprecision(6) << value;
+    fields.emplace_back(name, out.str());
+  };
+  add("backend", backend_name(options.backend));
+  if (mixed_size) {
+    add("width", "mixed");
+    add("height", "mixed");
+  } else {
+    add("width", width);
+    add("height", height);
+  }
+  if (mixed_mines) {
+    add("mines", "mixed");
+  } else {
+    add("mines", mines_count);
+  }
+  add("jobs", jobs);
+  add("seed", seed);
+  add("boards", options.boards);
+  add("ng_solvable", solved);
+  add("ng_success_rate", success_rate);
+  add("total_s", total_seconds);
+  add("boards_per_s", boards_per_second);
+  add("latency_p50_ms", percentile(latencies_ms, 50));
+  add("latency_p90_ms", percentile(latencies_ms, 90));
+  add("latency_p99_ms", percentile(latencies_ms, 99));
+  add("latency_max_ms", latencies_ms.back());
+  add("peak_rss_kb", peak_memory_kb());
+  const DeductionStats &tiers = solver.deduction_stats();
+  add("local_cells", tiers.local);
+  add("elimination_cells", tiers.elimination);
+  add("mine_count_cells", tiers.mine_count);
+  add("enumeration_cells", tiers.enumeration);
+
+  if (options.format == "json") {
+    std::cout << "{";
+    for (std::size_t i = 0; i < fields.size(); i++) {
+      bool is_text =
+          fields[i].first == "backend" || fields[i].second == "mixed";
+      std::cout << (i ? ", " : "") << '"' << fields[i].first << "\": "
+                << (is_text ? "\"" : "") << fields[i].second
+                << (is_text ? "\"" : "");
+    }
+    std::cout << "}" << std::endl;
+  } else {
+    for (std::size_t i = 0; i < fields.size(); i++) {
+      std::cout << (i ? "," : "") << fields[i].first;
+    }
+    std::cout << std::endl;
+    for (std::size_t i = 0; i < fields.size(); i++) {
+      std::cout << (i ? "," : "") << fields[i].second;
+    }
+    std::cout << std::endl;
+  }
+
+  return 0;
+}
@@ -0,0 +1,64 @@
+#ifndef BENCH_HPP
+#define BENCH_HPP
+
+#include "solver.hpp"
+#include <cstdint>
+#include <optional>
+#include <string>
+
+/**
+ * @brief Settings for the headless benchmark, see run_bench().
+ */
+struct BenchOptions {
+  int boards = 0;             ///< Number of boards to solve, 0 disables the benchmark.
+  std::string format = "csv"; ///< Output format, "csv" or "json".
+  EliminationBackend backend = EliminationBackend::incremental; ///< Backend the solver uses.
+  std::string profile_path; ///< File the SolveProfile of each board is written to, empty for none.
+  int batch = 1; ///< Boards handed to Solver::solve_batch() at once, 1 solves them one by one.
+};
+
+/**
+ * @brief Parses the name of an elimination backend.
+ *
+ * @param name One of "dense", "bitset" or "incremental", or the deprecated
+ *             "dense_float" for "dense".
+ * @return The backend, std::nullopt if the name is unknown.
+ */
+std::optional<EliminationBackend> parse_backend(const std::string &name);
+
+/**
+ * @brief The name parse_backend() accepts for a backend.
+ */
+std::string backend_name(EliminationBackend backend);
+
+/**
+ * @brief Solves boards without the ncurses interface and reports statistics.
+ *
+ * Generates options.boards random boards of the given size, solves the text
+ * board in file_path that many times, or streams that many boards from the
+ * archive in file_path, starting over when it runs out. Prints throughput, the
+ * no guess success rate, solve latency percentiles and peak memory as one CSV
+ * record or JSON object on stdout. With options.profile_path set the solves
+ * are profiled, which slows them down a little, and each profile is written
+ * as one line of JSON, one per batch when options.batch is above 1. The
+ * latency of a board solved in a batch is the batch's time over its size. A
+ * batch holds boards of one size, so an archive of several sizes starts a new
+ * batch at each change of size and reports its width, height or mines as
+ * "mixed".
+ *
+ * @param options The benchmark settings.
+ * @param width Number of columns of generated boards.
+ * @param height Number of rows of generated boards.
+ * @param mines_count Number of mines of generated boards.
+ * @param file_path A text board or board archive to solve instead of
+ *                  generating them, empty to generate.
+ * @param jobs Number of threads the solver uses for each board.
+ * @param seed Seed of the generated boards and of the solver, equal seeds
+ *             solve equal boards.
+ * @return Exit status code.
+ */
+int run_bench(const BenchOptions &options, int width, int height,
+              int mines_count, const std::string &file_path, int jobs,
+              std::uint64_t seed);
+
+#endif // BENCH_HPP
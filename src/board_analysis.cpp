@@ -0,0 +1,109 @@
+#include "board_analysis.hpp"
+#include <algorithm>
+
+// A copy of board with nothing revealed or flagged on the playing field
+static Board unplayed(const Board &board) {
+  Board copy = board;
+  for (int row = 0; row < copy.height(); row++) {
+    for (int col = 0; col < copy.width(); col++) {
+      Cell &cell = copy.at(row, col);
+      cell.is_revealed = false;
+      cell.is_flagged = false;
+    }
+  }
+  copy.recount();
+  return copy;
+}
+
+BoardMetrics measure_board(const Board &board) {
+  BoardMetrics metrics;
+  Board played = unplayed(board);
+  std::vector<int> revealed;
+
+  auto is_zero = [&](int idx) {
+    int row = played.row_of(idx);
+    int col = played.col_of(idx);
+    return played.in_bounds(row, col) && !played[idx].is_mine &&
+           played[idx].adjacent_mines == 0;
+  };
+
+  for (int row = 0; row < played.height(); row++) {
+    for (int col = 0; col < played.width(); col++) {
+      int idx = played.index(row, col);
+      if (played[idx].is_mine) {
+        continue;
+      }
+      if (played[idx].adjacent_mines == 0) {
+        // Zeros of an opening that was already flooded are revealed
+        if (!played[idx].is_revealed) {
+          reveal_cell(played, row, col, revealed);
+          metrics.openings++;
+        }
+        continue;
+      }
+      const auto &offsets = played.neighbour_offsets();
+      if (std::none_of(offsets.begin(), offsets.end(),
+                       [&](int offset) { return is_zero(idx + offset); })) {
+        metrics.bbbv++;
+      }
+    }
+  }
+  metrics.bbbv += metrics.openings;
+  return metrics;
+}
+
+BoardAnalysis analyze_board(const Board &board, int mine_count,
+                            Solver &solver) {
+  BoardAnalysis analysis;
+  analysis.metrics = measure_board(board);
+  solver.set_tracing(true);
+  analysis.safe_start = solver.solve(board, mine_count);
+  solver.set_tracing(false);
+  if (!analysis.safe_start.has_value()) {
+    return analysis;
+  }
+
+  const SolveTrace &trace = solver.trace();
+  analysis.cell_tiers = trace.cell_tiers;
+  analysis.max_rows = trace.max_rows;
+  analysis.max_columns = trace.max_columns;
+  for (DeductionTier tier : analysis.cell_tiers) {
+    analysis.hardest_tier = std::max(analysis.hardest_tier, tier);
+    switch (tier) {
+    case DeductionTier::local:
+      analysis.tiers.local++;
+      break;
+    case DeductionTier::elimination:
+      analysis.tiers.elimination++;
+      break;
+    case DeductionTier::mine_count:
+      analysis.tiers.mine_count++;
+      break;
+    case DeductionTier::enumeration:
+      analysis.tiers.enumeration++;
+      break;
+    case DeductionTier::unresolved:
+    case DeductionTier::given:
+      break;
+    }
+  }
+  return analysis;
+}
+
+const char *tier_name(DeductionTier tier) {
+  switch (tier) {
+  case DeductionTier::unresolved:
+    return "unresolved";
+  case DeductionTier::given:
+    return "given";
+  case DeductionTier::local:
+    return "local";
+  case DeductionTier::elimination:
+    return "elimination";
+  case DeductionTier::mine_count:
+    return "mine_count";
+  case DeductionTier::enumeration:
+    return "enumeration";
+  }
+  return "unknown";
+}
@@ -0,0 +1,65 @@
+#ifndef BOARD_ANALYSIS_HPP
+#define BOARD_ANALYSIS_HPP
+
+#include "game_logic.hpp"
+#include "solver.hpp"
+#include <functional>
+#include <optional>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Click counts of a board which need no solving, see measure_board().
+ */
+struct BoardMetrics {
+  int bbbv = 0;     ///< 3BV, the fewest clicks that clear the board: one per opening and one per number next to no zero.
+  int openings = 0; ///< Regions of connected zeros, each clears with one click.
+};
+
+/**
+ * @brief Decides from its metrics whether a candidate board is worth solving.
+ */
+using BoardFilter = std::function<bool(const BoardMetrics &)>;
+
+/**
+ * @brief How hard a board is to solve without guessing, see analyze_board().
+ *
+ * Boards sort by difficulty on hardest_tier first, then on the size of the
+ * largest system, then on 3BV.
+ */
+struct BoardAnalysis {
+  BoardMetrics metrics;
+  std::optional<std::pair<int, int>> safe_start; ///< (row, col) the solver starts from, std::nullopt if the board is not no guess solvable.
+  std::vector<DeductionTier> cell_tiers; ///< Tier which resolved each cell from safe_start, by padded index, empty if not solvable.
+  DeductionStats tiers;                  ///< Cells each tier resolved from safe_start.
+  DeductionTier hardest_tier = DeductionTier::unresolved; ///< The hardest tier any cell needed.
+  int max_rows = 0;    ///< Equations of the largest system reduced from safe_start.
+  int max_columns = 0; ///< Variables of the largest system, see SolveProfile::max_columns.
+};
+
+/**
+ * @brief Counts the 3BV and the openings of a board in one pass.
+ *
+ * Every zero not reached yet is opened with reveal_cell() on a copy of the
+ * board, which floods its whole opening, and every number next to no zero is
+ * a click of its own. What is revealed or flagged on board is ignored.
+ */
+BoardMetrics measure_board(const Board &board);
+
+/**
+ * @brief Measures a board and, if it is no guess solvable, how it solves.
+ *
+ * The solve which decides the board runs with tracing on, and the tiers and
+ * the largest system are read from the trace of the attempt from its start,
+ * see Solver::set_tracing(). This costs solve() and one pass over the board.
+ *
+ * @param solver The solver used for both, it is left with tracing off.
+ */
+BoardAnalysis analyze_board(const Board &board, int mine_count, Solver &solver);
+
+/**
+ * @brief The name of a tier, such as "local" or "enumeration".
+ */
+const char *tier_name(DeductionTier tier);
+
+#endif // BOARD_ANALYSIS_HPP
@@ -0,0 +1,251 @@
+#include "board_archive.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static constexpr char archive_magic[4] = {'C', 'J', 'M', 'A'};
+static constexpr std::uint32_t archive_version = 2;
+static constexpr std::size_t record_header_size = 24;
+static constexpr std::size_t v1_record_header_size = 16;
+static constexpr std::uint16_t no_start = 0xffff;
+
+// Reads a little-endian unsigned integer
+template <class T> static T load_le(const std::uint8_t *bytes) {
+  T value = 0;
+  for (std::size_t i = 0; i < sizeof(T); i++) {
+    value |= static_cast<T>(bytes[i]) << (8 * i);
+  }
+  return value;
+}
+
+template <class T> static void store_le(std::uint8_t *bytes, T value) {
+  for (std::size_t i = 0; i < sizeof(T); i++) {
+    bytes[i] = static_cast<std::uint8_t>(value >> (8 * i));
+  }
+}
+
+// Bytes of the mine bits of a width by height board, padded to 8 bytes
+static std::size_t padded_bits_size(int width, int height) {
+  std::size_t bytes = (static_cast<std::size_t>(width) * height + 7) / 8;
+  return (bytes + 7) & ~std::size_t{7};
+}
+
+// Views a record whose header is header_size bytes, bytes may run past it
+static BoardRecord view_record(std::span<const std::uint8_t> bytes,
+                               std::size_t header_size) {
+  if (bytes.size() < header_size) {
+    throw std::runtime_error("Board archive is truncated");
+  }
+  const std::uint8_t *header = bytes.data();
+  BoardRecord record;
+  record.width = load_le<std::uint16_t>(header);
+  record.height = load_le<std::uint16_t>(header + 2);
+  record.mine_count = static_cast<int>(load_le<std::uint32_t>(header + 4));
+  record.seed = load_le<std::uint64_t>(header + 8);
+  if (header_size == record_header_size) {
+    std::uint16_t row = load_le<std::uint16_t>(header + 16);
+    std::uint16_t col = load_le<std::uint16_t>(header + 18);
+    if (row != no_start && col != no_start) {
+      record.start_row = row;
+      record.start_col = col;
+    }
+  }
+
+  if (padded_bits_size(record.width, record.height) >
+      bytes.size() - header_size) {
+    throw std::runtime_error("Board archive is truncated");
+  }
+  record.mine_bits = bytes.subspan(
+      header_size,
+      (static_cast<std::size_t>(record.width) * record.height + 7) / 8);
+  return record;
+}
+
+Board BoardRecord::to_board() const {
+  Board board(height, width);
+  for (int row = 0; row < height; row++) {
+    for (int col = 0; col < width; col++) {
+      if (is_mine(row, col)) {
+        board.set_mine(board.index(row, col), true);
+      }
+    }
+  }
+  if (board.mine_count() != mine_count) {
+    throw std::runtime_error("Board archive mine count does not match its mines");
+  }
+  count_adjacent_mines(board);
+  if (board.in_bounds(start_row, start_col)) {
+    board.at(start_row, start_col).safe_start = true;
+  }
+  return board;
+}
+
+void encode_archive_header(std::uint64_t count,
+                           std::uint8_t (&header)[board_archive_header_size]) {
+  std::memcpy(header, archive_magic, sizeof(archive_magic));
+  store_le<std::uint32_t>(header + 4, archive_version);
+  store_le<std::uint64_t>(header + 8, count);
+}
+
+std::optional<std::uint64_t>
+decode_archive_header(const std::uint8_t (&header)[board_archive_header_size]) {
+  if (std::memcmp(header, archive_magic, sizeof(archive_magic)) != 0 ||
+      load_le<std::uint32_t>(header + 4) != archive_version) {
+    return std::nullopt;
+  }
+  return load_le<std::uint64_t>(header + 8);
+}
+
+std::size_t board_record_size(int width, int height) {
+  return record_header_size + padded_bits_size(width, height);
+}
+
+void encode_board_record(const Board &board, std::uint64_t seed,
+                         std::vector<std::uint8_t> &out) {
+  if (board.width() > 0xffff || board.height() > 0xffff) {
+    throw std::runtime_error("Board is too large for a board archive");
+  }
+
+  out.assign(board_record_size(board.width(), board.height()), 0);
+  store_le<std::uint16_t>(out.data(), board.width());
+  store_le<std::uint16_t>(out.data() + 2, board.height());
+  store_le<std::uint32_t>(out.data() + 4, board.mine_count());
+  store_le<std::uint64_t>(out.data() + 8, seed);
+  store_le<std::uint16_t>(out.data() + 16, no_start);
+  store_le<std::uint16_t>(out.data() + 18, no_start);
+
+  std::uint8_t *bits = out.data() + record_header_size;
+  int bit = 0;
+  for (int row = 0; row < board.height(); row++) {
+    for (int col = 0; col < board.width(); col++, bit++) {
+      const Cell &cell = board.at(row, col);
+      if (cell.is_mine) {
+        bits[bit >> 3] |= 1 << (bit & 7);
+      }
+      if (cell.safe_start) {
+        store_le<std::uint16_t>(out.data() + 16, row);
+        store_le<std::uint16_t>(out.data() + 18, col);
+      }
+    }
+  }
+}
+
+BoardRecord view_board_record(std::span<const std::uint8_t> bytes) {
+  return view_record(bytes, record_header_size);
+}
+
+BoardArchive::BoardArchive(const std::string &path) {
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("Failed to open file");
+  }
+  struct stat status {};
+  if (::fstat(fd, &status) != 0 ||
+      static_cast<std::size_t>(status.st_size) < board_archive_header_size) {
+    ::close(fd);
+    throw std::runtime_error("File is not a board archive");
+  }
+  length_ = static_cast<std::size_t>(status.st_size);
+  void *mapping = ::mmap(nullptr, length_, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd); // the mapping keeps the file alive
+  if (mapping == MAP_FAILED) {
+    throw std::runtime_error("Failed to map file");
+  }
+  ::madvise(mapping, length_, MADV_SEQUENTIAL);
+  data_ = static_cast<const std::uint8_t *>(mapping);
+
+  std::uint32_t version = load_le<std::uint32_t>(data_ + 4);
+  if (std::memcmp(data_, archive_magic, sizeof(archive_magic)) != 0 ||
+      (version != 1 && version != archive_version)) {
+    ::munmap(mapping, length_);
+    throw std::runtime_error("File is not a board archive");
+  }
+  count_ = load_le<std::uint64_t>(data_ + 8);
+  record_header_size_ =
+      version == 1 ? v1_record_header_size : record_header_size;
+}
+
+BoardArchive::~BoardArchive() {
+  ::munmap(const_cast<std::uint8_t *>(data_), length_);
+}
+
+BoardArchive::iterator BoardArchive::begin() const {
+  return iterator(this, board_archive_header_size, 0);
+}
+
+BoardRecord BoardArchive::iterator::operator*() const {
+  std::span<const std::uint8_t> rest(archive_->data_, archive_->length_);
+  return view_record(rest.subspan(std::min(offset_, rest.size())),
+                     archive_->record_header_size_);
+}
+
+BoardArchive::iterator &BoardArchive::iterator::operator++() {
+  BoardRecord record = **this;
+  offset_ += archive_->record_header_size_ +
+             padded_bits_size(record.width, record.height);
+  index_++;
+  return *this;
+}
+
+bool is_board_archive(const std::string &path) {
+  std::ifstream file(path, std::ios::binary);
+  char magic[sizeof(archive_magic)] = {};
+  file.read(magic, sizeof(magic));
+  return file.gcount() == sizeof(magic) &&
+         std::memcmp(magic, archive_magic, sizeof(magic)) == 0;
+}
+
+std::pair<Board, int> read_board_or_archive(const std::string &path) {
+  if (!is_board_archive(path)) {
+    return read_board_from_file(path);
+  }
+  BoardArchive archive(path);
+  if (archive.size() == 0) {
+    throw std::runtime_error("File does not contain a board");
+  }
+  BoardRecord record = *archive.begin();
+  return {record.to_board(), record.mine_count};
+}
+
+BoardArchiveWriter::BoardArchiveWriter(const std::string &path)
+    : file(path, std::ios::binary | std::ios::trunc) {
+  if (!file.is_open()) {
+    throw std::runtime_error("Failed to create file");
+  }
+  std::uint8_t header[board_archive_header_size];
+  encode_archive_header(0, header);
+  file.write(reinterpret_cast<const char *>(header), sizeof(header));
+}
+
+BoardArchiveWriter::~BoardArchiveWriter() {
+  try {
+    close();
+  } catch (const std::runtime_error &) {
+    // a failed write can only be reported by calling close() explicitly
+  }
+}
+
+void BoardArchiveWriter::add(const Board &board, std::uint64_t seed) {
+  encode_board_record(board, seed, buffer);
+  file.write(reinterpret_cast<const char *>(buffer.data()), buffer.size());
+  count++;
+}
+
+void BoardArchiveWriter::close() {
+  if (!file.is_open()) {
+    return;
+  }
+  std::uint8_t header[board_archive_header_size];
+  encode_archive_header(count, header);
+  file.seekp(0);
+  file.write(reinterpret_cast<const char *>(header), sizeof(header));
+  bool written = file.good();
+  file.close();
+  if (!written) {
+    throw std::runtime_error("Failed to write board archive");
+  }
+}
@@ -0,0 +1,204 @@
+#ifndef BOARD_ARCHIVE_HPP
+#define BOARD_ARCHIVE_HPP
+
+#include "game_logic.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+/**
+ * @brief One board of a BoardArchive, viewed in place in the mapped file.
+ *
+ * On disk a board is a 24 byte little-endian header, width and height as
+ * uint16, the mine count as uint32, the seed as uint64, the safe start row
+ * and column as uint16, 0xffff if there is none, and 4 reserved bytes. It is
+ * followed by one bit per cell in row-major order, least significant bit
+ * first, padded to a multiple of 8 bytes. Version 1 archives have a 16 byte
+ * header without the safe start. A view stays valid as long as its archive is
+ * open.
+ */
+struct BoardRecord {
+  int width = 0;
+  int height = 0;
+  int mine_count = 0;
+  std::uint64_t seed = 0; ///< Seed the board was generated from, 0 if unknown.
+  int start_row = -1;     ///< Row of the safe start, -1 if there is none.
+  int start_col = -1;     ///< Column of the safe start, -1 if there is none.
+  std::span<const std::uint8_t> mine_bits; ///< (width * height + 7) / 8 bytes.
+
+  bool is_mine(int row, int col) const {
+    int bit = row * width + col;
+    return (mine_bits[bit >> 3] >> (bit & 7)) & 1;
+  }
+
+  /**
+   * @brief Builds the playable board, with adjacent mine counts and the safe
+   * start filled in.
+   *
+   * @throws std::runtime_error if the mine count does not match the mine bits.
+   */
+  Board to_board() const;
+};
+
+/**
+ * @brief A read-only, memory-mapped file of boards in the binary format.
+ *
+ * The file starts with a 16 byte header, the magic "CJMA", a uint32 version
+ * and the uint64 number of boards at byte 8, followed by the boards one after
+ * another, see BoardRecord. Nothing is copied or parsed up front, iterating reads each
+ * board's header in place, so a corpus of millions of boards streams through
+ * the page cache.
+ */
+class BoardArchive {
+public:
+  /**
+   * @brief Maps the archive in path.
+   *
+   * @throws std::runtime_error if the file cannot be mapped or is not an
+   *         archive.
+   */
+  explicit BoardArchive(const std::string &path);
+  ~BoardArchive();
+
+  BoardArchive(const BoardArchive &) = delete;
+  BoardArchive &operator=(const BoardArchive &) = delete;
+
+  std::uint64_t size() const { return count_; }
+
+  /**
+   * @brief Steps through the boards in file order.
+   *
+   * Dereferencing or advancing past the end of the mapped file throws
+   * std::runtime_error, so a truncated archive is caught at the bad board.
+   */
+  class iterator {
+  public:
+    using value_type = BoardRecord;
+    using difference_type = std::ptrdiff_t;
+
+    iterator() = default;
+    BoardRecord operator*() const;
+    iterator &operator++();
+    iterator operator++(int) {
+      iterator old = *this;
+      ++*this;
+      return old;
+    }
+    bool operator==(const iterator &other) const {
+      return index_ == other.index_;
+    }
+
+  private:
+    friend class BoardArchive;
+    iterator(const BoardArchive *archive, std::size_t offset,
+             std::uint64_t index)
+        : archive_(archive), offset_(offset), index_(index) {}
+
+    const BoardArchive *archive_ = nullptr;
+    std::size_t offset_ = 0;
+    std::uint64_t index_ = 0;
+  };
+
+  iterator begin() const;
+  iterator end() const { return iterator(this, 0, count_); }
+
+private:
+  const std::uint8_t *data_ = nullptr;
+  std::size_t length_ = 0;
+  std::uint64_t count_ = 0;
+  std::size_t record_header_size_ = 0;
+};
+
+/**
+ * @brief Checks whether the file in path starts with the archive magic.
+ */
+bool is_board_archive(const std::string &path);
+
+/**
+ * @brief Size of the header of an archive file, the board count is its last
+ * 8 bytes.
+ */
+inline constexpr std::size_t board_archive_header_size = 16;
+
+/**
+ * @brief Encodes the header of an archive file holding count boards.
+ */
+void encode_archive_header(std::uint64_t count,
+                           std::uint8_t (&header)[board_archive_header_size]);
+
+/**
+ * @brief Decodes the header of an archive file written by this version.
+ *
+ * @return The number of boards, std::nullopt if header is not of this version.
+ */
+std::optional<std::uint64_t>
+decode_archive_header(const std::uint8_t (&header)[board_archive_header_size]);
+
+/**
+ * @brief Bytes one width by height board takes in an archive written by this
+ * version.
+ */
+std::size_t board_record_size(int width, int height);
+
+/**
+ * @brief Encodes the mine layout and safe start of board as one archive
+ * board, what has been revealed or flagged is not stored.
+ *
+ * @param out Replaced by the board_record_size() bytes of the record.
+ * @throws std::runtime_error if the board is larger than 65535 cells along
+ *         a side.
+ */
+void encode_board_record(const Board &board, std::uint64_t seed,
+                         std::vector<std::uint8_t> &out);
+
+/**
+ * @brief Views one board encoded by encode_board_record().
+ *
+ * @throws std::runtime_error if bytes is shorter than the record.
+ */
+BoardRecord view_board_record(std::span<const std::uint8_t> bytes);
+
+/**
+ * @brief Reads the first board of an archive, or a text board as
+ * read_board_from_file() does.
+ *
+ * @return The board and the number of mines on it.
+ * @throws std::runtime_error if the file cannot be read or holds no board.
+ */
+std::pair<Board, int> read_board_or_archive(const std::string &path);
+
+/**
+ * @brief Appends boards to a new archive file.
+ *
+ * The board count in the header is written by close(), which the destructor
+ * also runs.
+ */
+class BoardArchiveWriter {
+public:
+  /**
+   * @throws std::runtime_error if the file cannot be created.
+   */
+  explicit BoardArchiveWriter(const std::string &path);
+  ~BoardArchiveWriter();
+
+  /**
+   * @brief Appends board, see encode_board_record().
+   */
+  void add(const Board &board, std::uint64_t seed = 0);
+
+  /**
+   * @throws std::runtime_error if any board could not be written.
+   */
+  void close();
+
+private:
+  std::ofstream file;
+  std::uint64_t count = 0;
+  std::vector<std::uint8_t> buffer; ///< One encoded board, reused.
+};
+
+#endif // BOARD_ARCHIVE_HPP
@@ -0,0 +1,196 @@
+#include "board_pool.hpp"
+#include "board_archive.hpp"
+#include <fcntl.h>
+#include <filesystem>
+#include <stdexcept>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+// A pool file held open under an flock() for the lifetime of the object
+class LockedFile {
+public:
+  LockedFile(const std::string &path, int flags, int lock) {
+    fd = ::open(path.c_str(), flags, 0644);
+    if (fd >= 0 && ::flock(fd, lock) != 0) {
+      ::close(fd);
+      fd = -1;
+    }
+  }
+  ~LockedFile() {
+    if (fd >= 0) {
+      ::close(fd); // closing releases the lock
+    }
+  }
+  LockedFile(const LockedFile &) = delete;
+  LockedFile &operator=(const LockedFile &) = delete;
+
+  bool is_open() const { return fd >= 0; }
+
+  bool read_at(void *data, std::size_t size, off_t offset) const {
+    return ::pread(fd, data, size, offset) == static_cast<ssize_t>(size);
+  }
+
+  bool write_at(const void *data, std::size_t size, off_t offset) const {
+    return ::pwrite(fd, data, size, offset) == static_cast<ssize_t>(size);
+  }
+
+  // Number of boards of record_size bytes, std::nullopt unless the file is an
+  // archive or empty. Bytes past the last board are left by an interrupted
+  // push or pop and are ignored
+  std::optional<std::uint64_t> count(std::size_t record_size) const {
+    struct stat status {};
+    if (::fstat(fd, &status) != 0) {
+      return std::nullopt;
+    }
+    if (status.st_size == 0) {
+      return 0;
+    }
+    std::uint8_t header[board_archive_header_size];
+    if (!read_at(header, sizeof(header), 0)) {
+      return std::nullopt;
+    }
+    std::optional<std::uint64_t> count = decode_archive_header(header);
+    if (!count.has_value() ||
+        static_cast<std::uint64_t>(status.st_size) <
+            board_archive_header_size + *count * record_size) {
+      return std::nullopt;
+    }
+    return count;
+  }
+
+  bool write_count(std::uint64_t count) const {
+    std::uint8_t header[board_archive_header_size];
+    encode_archive_header(count, header);
+    return write_at(header, sizeof(header), 0);
+  }
+
+  bool truncate(off_t length) const { return ::ftruncate(fd, length) == 0; }
+
+private:
+  int fd = -1;
+};
+
+BoardPool::BoardPool(std::string directory, std::size_t capacity)
+    : directory(std::move(directory)), capacity(capacity) {}
+
+BoardPool::~BoardPool() = default; // the refill thread stops and joins
+
+std::string BoardPool::path_of(int width, int height, int mines_count) const {
+  return (std::filesystem::path(directory) /
+          (std::to_string(width) + "x" + std::to_string(height) + "_" +
+           std::to_string(mines_count) + ".cjma"))
+      .string();
+}
+
+std::optional<NoGuessBoard> BoardPool::pop(int width, int height,
+                                           int mines_count,
+                                           const BoardFilter &accept) {
+  LockedFile file(path_of(width, height, mines_count), O_RDWR, LOCK_EX);
+  if (!file.is_open()) {
+    return std::nullopt;
+  }
+  std::size_t record_size = board_record_size(width, height);
+  std::optional<std::uint64_t> count = file.count(record_size);
+  if (!count.has_value() || *count == 0) {
+    return std::nullopt;
+  }
+
+  // Newest first, a board accept rejects is left where it is
+  std::vector<std::uint8_t> bytes(record_size);
+  std::optional<NoGuessBoard> board;
+  std::uint64_t position = *count;
+  while (!board.has_value() && position > 0) {
+    position--;
+    off_t offset = board_archive_header_size + position * record_size;
+    if (!file.read_at(bytes.data(), bytes.size(), offset)) {
+      return std::nullopt;
+    }
+    BoardRecord record = view_board_record(bytes);
+    if (record.width != width || record.height != height ||
+        record.mine_count != mines_count || record.start_row < 0) {
+      return std::nullopt;
+    }
+    try {
+      board =
+          NoGuessBoard{record.to_board(), {record.start_row, record.start_col}};
+    } catch (const std::runtime_error &) {
+      return std::nullopt;
+    }
+    if (accept && !accept(measure_board(board->board))) {
+      board.reset();
+    }
+  }
+  if (!board.has_value()) {
+    return std::nullopt;
+  }
+
+  // The last board fills the hole, then the count shrinks first, a crash in
+  // between leaves a readable archive
+  off_t last = board_archive_header_size + (*count - 1) * record_size;
+  if (position + 1 < *count) {
+    if (!file.read_at(bytes.data(), bytes.size(), last) ||
+        !file.write_at(bytes.data(), bytes.size(),
+                       board_archive_header_size + position * record_size)) {
+      return std::nullopt;
+    }
+  }
+  if (!file.write_count(*count - 1) || !file.truncate(last)) {
+    return std::nullopt;
+  }
+  return board;
+}
+
+void BoardPool::push(const NoGuessBoard &board, std::uint64_t seed) {
+  const Board &layout = board.board;
+  std::filesystem::create_directories(directory);
+  LockedFile file(path_of(layout.width(), layout.height(), layout.mine_count()),
+                  O_RDWR | O_CREAT, LOCK_EX);
+  if (!file.is_open()) {
+    throw std::runtime_error("Failed to open board pool");
+  }
+  std::size_t record_size = board_record_size(layout.width(), layout.height());
+  std::optional<std::uint64_t> count = file.count(record_size);
+  if (!count.has_value()) {
+    throw std::runtime_error("Board pool file is damaged");
+  }
+
+  std::vector<std::uint8_t> bytes;
+  encode_board_record(layout, seed, bytes);
+  off_t offset = board_archive_header_size + *count * record_size;
+  if (!file.write_at(bytes.data(), bytes.size(), offset) ||
+      !file.write_count(*count + 1)) {
+    throw std::runtime_error("Failed to write board pool");
+  }
+}
+
+std::size_t BoardPool::size(int width, int height, int mines_count) const {
+  LockedFile file(path_of(width, height, mines_count), O_RDONLY, LOCK_SH);
+  if (!file.is_open()) {
+    return 0;
+  }
+  return file.count(board_record_size(width, height)).value_or(0);
+}
+
+void BoardPool::refill(int width, int height, int mines_count,
+                       std::uint64_t seed) {
+  refill_thread = std::jthread([=, this](std::stop_token stop) {
+    Rng rng(seed);
+    while (not stop.stop_requested() &&
+           size(width, height, mines_count) < capacity) {
+      std::uint64_t board_seed = rng();
+      std::optional<NoGuessBoard> board =
+          generate_no_guess_board(mines_count, height, width, 1,
+                                  GenerationMode::reroll, board_seed, stop);
+      if (!board.has_value()) {
+        return;
+      }
+      try {
+        push(*board, board_seed);
+      } catch (const std::exception &) {
+        return;
+      }
+    }
+  });
+}
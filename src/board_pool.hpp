@@ -0,0 +1,83 @@
+#ifndef BOARD_POOL_HPP
+#define BOARD_POOL_HPP
+
+#include "no_guess_generator.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <thread>
+
+/**
+ * @brief An on-disk pool of no guess boards, so a game can start without
+ * waiting for the generator.
+ *
+ * Boards of each (width, height, mines) live in their own board archive in
+ * the pool directory, e.g. 30x16_99.cjma, which --validate and --bench can
+ * read like any other. Boards are pushed and popped at the end of the file,
+ * which takes constant time, and every access holds an flock() on the file so
+ * several games can share one pool.
+ */
+class BoardPool {
+public:
+  /**
+   * @param directory Directory of the pool, created when first written to.
+   * @param capacity Number of boards refill() keeps in each file.
+   */
+  explicit BoardPool(std::string directory, std::size_t capacity = 16);
+
+  /**
+   * @brief Stops a running refill and waits for it.
+   */
+  ~BoardPool();
+
+  BoardPool(const BoardPool &) = delete;
+  BoardPool &operator=(const BoardPool &) = delete;
+
+  /**
+   * @brief Removes the most recently pushed board of the given size that
+   * accept takes.
+   *
+   * Boards accept rejects stay in the pool for other filters. Taking a board
+   * from the middle moves the last board into its place.
+   *
+   * @param accept Filter on the metrics of the boards, empty to take the last.
+   * @return The board with its safe start marked, std::nullopt if there is
+   *         none or the pool file cannot be read.
+   */
+  std::optional<NoGuessBoard> pop(int width, int height, int mines_count,
+                                  const BoardFilter &accept = {});
+
+  /**
+   * @brief Appends a generated board, its mine count and safe start are
+   * taken from the board.
+   *
+   * @throws std::runtime_error if the pool file cannot be written.
+   */
+  void push(const NoGuessBoard &board, std::uint64_t seed = 0);
+
+  /**
+   * @brief Number of boards of the given size in the pool.
+   */
+  std::size_t size(int width, int height, int mines_count) const;
+
+  /**
+   * @brief Starts a background thread that generates boards of the given size
+   * on one core until the pool holds capacity of them.
+   *
+   * A refill that is already running is stopped first. Failures to write are
+   * dropped, the pool is only a cache.
+   *
+   * @param seed Seed of the generated boards.
+   */
+  void refill(int width, int height, int mines_count, std::uint64_t seed);
+
+private:
+  std::string directory;
+  std::size_t capacity;
+  std::jthread refill_thread;
+
+  std::string path_of(int width, int height, int mines_count) const;
+};
+
+#endif // BOARD_POOL_HPP
@@ -0,0 +1,87 @@
+#ifndef BOARD_SHAPE_HPP
+#define BOARD_SHAPE_HPP
+
+#include "game_logic.hpp"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief The dimensions of a board known at compile time.
+ *
+ * Kernels templated on a shape read the width, stride and neighbour offsets
+ * through it, so for a FixedShape they are constants, the neighbour loops
+ * unroll and scratch buffers of one value per cell can live in a std::array.
+ * The layout is the same padded one Board uses, see Board::index().
+ */
+template <int Width, int Height> struct FixedShape {
+  static constexpr int width = Width;
+  static constexpr int height = Height;
+  static constexpr int stride = Width + 2;
+  static constexpr int cell_count = Width * Height;
+  static constexpr int padded_size = (Height + 2) * stride;
+  static constexpr std::array<int, 8> offsets = {
+      -stride - 1, -stride, -stride + 1, -1, 1, stride - 1, stride, stride + 1};
+
+  using CellBuffer = std::array<int, cell_count>;
+  using PlaneBuffer = std::array<std::uint8_t, padded_size>;
+  using RowBuffer = std::array<std::uint8_t, stride>;
+
+  static constexpr int index(int row, int col) {
+    return (row + 1) * stride + col + 1;
+  }
+  static CellBuffer cell_buffer() { return {}; }
+  static PlaneBuffer plane_buffer() { return {}; }
+  static RowBuffer row_buffer() { return {}; }
+};
+
+/**
+ * @brief The dimensions of a board of any size, read at run time.
+ */
+struct DynamicShape {
+  int width;
+  int height;
+  int stride;
+  int cell_count;
+  int padded_size;
+  std::array<int, 8> offsets;
+
+  using CellBuffer = std::vector<int>;
+  using PlaneBuffer = std::vector<std::uint8_t>;
+  using RowBuffer = std::vector<std::uint8_t>;
+
+  /**
+   * @param board A Board, or anything with its size queries such as a SolverState.
+   */
+  template <class Layout>
+  explicit DynamicShape(const Layout &board)
+      : width(board.width()), height(board.height()), stride(board.stride()),
+        cell_count(board.cell_count()), padded_size(board.padded_size()),
+        offsets(board.neighbour_offsets()) {}
+
+  int index(int row, int col) const { return (row + 1) * stride + col + 1; }
+  CellBuffer cell_buffer() const { return CellBuffer(cell_count); }
+  PlaneBuffer plane_buffer() const { return PlaneBuffer(padded_size); }
+  RowBuffer row_buffer() const { return RowBuffer(stride); }
+};
+
+/**
+ * @brief Calls kernel with the FixedShape of board if it is one of the
+ * standard sizes, beginner 9x9, intermediate 16x16 or expert 30x16 (width by
+ * height), and with its DynamicShape otherwise.
+ *
+ * @return What kernel returns, which must be the same type for every shape.
+ */
+template <class Layout, class Kernel>
+decltype(auto) dispatch_shape(const Layout &board, Kernel &&kernel) {
+  if (board.width() == 9 && board.height() == 9) {
+    return kernel(FixedShape<9, 9>{});
+  } else if (board.width() == 16 && board.height() == 16) {
+    return kernel(FixedShape<16, 16>{});
+  } else if (board.width() == 30 && board.height() == 16) {
+    return kernel(FixedShape<30, 16>{});
+  }
+  return kernel(DynamicShape(board));
+}
+
+#endif // BOARD_SHAPE_HPP
@@ -0,0 +1,68 @@
+#ifndef BOUNDED_QUEUE_HPP
+#define BOUNDED_QUEUE_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+/**
+ * @brief A first in first out queue shared between threads that holds at most
+ * a fixed number of items, so a fast producer waits for its consumers.
+ */
+template <class T> class BoundedQueue {
+public:
+  explicit BoundedQueue(std::size_t capacity) : capacity(capacity) {}
+
+  /**
+   * @brief Waits for room and appends item, items pushed after close() are
+   * dropped.
+   */
+  void push(T item) {
+    std::unique_lock lock(mutex);
+    not_full.wait(lock, [&] { return items.size() < capacity || closed; });
+    if (closed) {
+      return;
+    }
+    items.push_back(std::move(item));
+    not_empty.notify_one();
+  }
+
+  /**
+   * @brief Waits for an item and removes it.
+   *
+   * @return The oldest item, std::nullopt once the queue is closed and empty.
+   */
+  std::optional<T> pop() {
+    std::unique_lock lock(mutex);
+    not_empty.wait(lock, [&] { return !items.empty() || closed; });
+    if (items.empty()) {
+      return std::nullopt;
+    }
+    T item = std::move(items.front());
+    items.pop_front();
+    not_full.notify_one();
+    return item;
+  }
+
+  /**
+   * @brief Wakes every waiting thread, consumers still drain what is queued.
+   */
+  void close() {
+    std::lock_guard lock(mutex);
+    closed = true;
+    not_empty.notify_all();
+    not_full.notify_all();
+  }
+
+private:
+  std::size_t capacity;
+  std::deque<T> items;
+  bool closed = false;
+  std::mutex mutex;
+  std::condition_variable not_empty;
+  std::condition_variable not_full;
+};
+
+#endif // BOUNDED_QUEUE_HPP
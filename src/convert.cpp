@@ -0,0 +1,28 @@
+#include "board_archive.hpp"
+#include <iostream>
+#include <stdexcept>
+
+// Converts text minefields, as read by read_board_from_file(), into one
+// binary board archive
+int main(int argc, char *argv[]) {
+  if (argc < 3) {
+    std::cerr << "Usage: cjmines_convert <output archive> <text board>..."
+              << std::endl;
+    return 1;
+  }
+
+  try {
+    BoardArchiveWriter writer(argv[1]);
+    for (int i = 2; i < argc; i++) {
+      auto [board, mine_count] = read_board_from_file(argv[i]);
+      writer.add(board);
+    }
+    writer.close();
+  } catch (const std::runtime_error &error) {
+    std::cerr << error.what() << std::endl;
+    return 1;
+  }
+
+  std::cout << "wrote " << argc - 2 << " boards to " << argv[1] << std::endl;
+  return 0;
+}
@@ -0,0 +1,196 @@
+#include "corpus_validation.hpp"
+#include "board_archive.hpp"
+#include "bounded_queue.hpp"
+#include "solver.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// One board on its way from the reader to a worker
+struct CorpusItem {
+  long seq = 0;
+  std::string source;
+  long index = 0;
+  std::optional<std::pair<Board, int>> board; ///< Empty if it could not be read.
+  std::string error;
+};
+
+using EmitBoard = std::function<void(
+    const std::string &source, long index,
+    std::optional<std::pair<Board, int>> board, const std::string &error)>;
+
+// Emits every board of a stream of text boards
+static void read_text_boards(std::istream &in, const std::string &source,
+                             const EmitBoard &emit) {
+  long index = 0;
+  try {
+    while (auto board = read_board_from_stream(in)) {
+      emit(source, index++, std::move(board), "");
+    }
+  } catch (const std::exception &error) {
+    emit(source, index, std::nullopt, error.what());
+  }
+}
+
+static void read_file(const std::string &path, const EmitBoard &emit) {
+  if (is_board_archive(path)) {
+    long index = 0;
+    try {
+      BoardArchive archive(path);
+      for (BoardRecord record : archive) {
+        emit(path, index++, std::pair{record.to_board(), record.mine_count},
+             "");
+      }
+    } catch (const std::runtime_error &error) {
+      emit(path, index, std::nullopt, error.what());
+    }
+    return;
+  }
+
+  std::ifstream file(path);
+  if (!file.is_open()) {
+    emit(path, 0, std::nullopt, "Failed to open file");
+    return;
+  }
+  read_text_boards(file, path, emit);
+}
+
+static void read_corpus(const std::string &path, const EmitBoard &emit) {
+  if (path == "-") {
+    read_text_boards(std::cin, path, emit);
+    return;
+  }
+
+  std::error_code error;
+  if (!std::filesystem::is_directory(path, error)) {
+    read_file(path, emit);
+    return;
+  }
+
+  std::vector<std::string> files;
+  for (const auto &entry : std::filesystem::directory_iterator(path, error)) {
+    if (entry.is_regular_file()) {
+      files.push_back(entry.path().string());
+    }
+  }
+  std::sort(files.begin(), files.end());
+  for (const std::string &file : files) {
+    read_file(file, emit);
+  }
+}
+
+CorpusSummary validate_corpus(const std::string &path, std::ostream &out,
+                              int jobs, std::uint64_t seed) {
+  int num_workers = std::max(1, jobs);
+  BoundedQueue<CorpusItem> queue(2 * num_workers);
+
+  // Verdicts finish out of order, they wait in a ring of window slots until
+  // every earlier board has been written
+  const long window = 4 * num_workers + 16;
+  std::vector<std::optional<std::string>> finished(window);
+  long next_to_write = 0;
+  CorpusSummary summary;
+  std::mutex order_mutex;
+  std::condition_variable window_open;
+
+  // The first exception of the reader or of a worker, it stops the others
+  // and is rethrown once they have joined
+  std::exception_ptr failure;
+  bool stopped = false;
+  auto stop = [&](std::exception_ptr error) {
+    {
+      std::lock_guard lock(order_mutex);
+      if (!failure) {
+        failure = error;
+      }
+      stopped = true;
+    }
+    queue.close();
+    window_open.notify_all();
+  };
+
+  auto validate = [&] {
+    Solver solver(EliminationBackend::incremental, false);
+    while (std::optional<CorpusItem> item = queue.pop()) {
+      std::ostringstream line;
+      line << item->source << ' ' << item->index << ' ';
+      bool solvable = false;
+      if (item->board.has_value()) {
+        auto &[board, mines] = item->board.value();
+        solver.reseed(Rng::stream_seed(seed, item->seq));
+        std::optional<std::pair<int, int>> start = solver.solve(board, mines);
+        solvable = start.has_value();
+        if (solvable) {
+          line << "ngs " << start->first << ' ' << start->second;
+        } else {
+          line << "not_ngs";
+        }
+      } else {
+        line << "error " << item->error;
+      }
+
+      std::lock_guard lock(order_mutex);
+      summary.boards++;
+      summary.solvable += solvable;
+      summary.errors += !item->board.has_value();
+      finished[item->seq % window] = line.str();
+      while (finished[next_to_write % window].has_value()) {
+        out << *finished[next_to_write % window] << '\n';
+        finished[next_to_write % window].reset();
+        next_to_write++;
+      }
+      window_open.notify_one();
+    }
+  };
+  auto worker = [&] {
+    try {
+      validate();
+    } catch (...) {
+      stop(std::current_exception());
+    }
+  };
+
+  {
+    std::vector<std::jthread> workers;
+    for (int id = 0; id < num_workers; ++id) {
+      workers.emplace_back(worker);
+    }
+
+    long seq = 0;
+    try {
+      read_corpus(path, [&](const std::string &source, long index,
+                            std::optional<std::pair<Board, int>> board,
+                            const std::string &error) {
+        {
+          std::unique_lock lock(order_mutex);
+          window_open.wait(lock, [&] {
+            return stopped || seq < next_to_write + window;
+          });
+          if (stopped) {
+            return;
+          }
+        }
+        queue.push(CorpusItem{seq++, source, index, std::move(board), error});
+      });
+    } catch (...) {
+      stop(std::current_exception());
+    }
+    queue.close();
+  } // the workers join here
+
+  out.flush();
+  if (failure) {
+    std::rethrow_exception(failure);
+  }
+  return summary;
+}
@@ -0,0 +1,40 @@
+#ifndef CORPUS_VALIDATION_HPP
+#define CORPUS_VALIDATION_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+/**
+ * @brief Totals of a validate_corpus() run.
+ */
+struct CorpusSummary {
+  long boards = 0;   ///< Boards checked, unreadable ones included.
+  long solvable = 0; ///< Boards that are no guess solvable.
+  long errors = 0;   ///< Boards or files that could not be read.
+};
+
+/**
+ * @brief Checks every board of a corpus for no guess solvability.
+ *
+ * path is a board archive, a text file of boards separated by blank lines, a
+ * directory whose regular files are read in name order, or "-" for text
+ * boards on stdin. One thread reads the boards into a bounded queue which a
+ * pool of jobs Solvers drains, and at most a fixed window of boards is in
+ * flight between reading and writing, so memory stays flat for any corpus.
+ *
+ * One line per board is written to out in input order, the source and the
+ * index of the board within it followed by "ngs" and the safe start row and
+ * column, "not_ngs", or "error" and a message. A source that fails to read
+ * gets an error line and is skipped from there on.
+ *
+ * @param jobs Number of solver threads, at least one is used.
+ * @param seed Seed of the order the starts are tried in, with equal seeds the
+ *             output is the same for any number of jobs.
+ * @throws Whatever the reader or a solver thread threw first, once every
+ *         thread has stopped.
+ */
+CorpusSummary validate_corpus(const std::string &path, std::ostream &out,
+                              int jobs, std::uint64_t seed);
+
+#endif // CORPUS_VALIDATION_HPP
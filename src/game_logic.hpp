@@ -2,39 +2,203 @@
 #define GAME_LOGIC_HPP
 
 
+#include <array>
+#include <cstdint>
 #include <cstdlib>
+#include <istream>
+#include <optional>
 #include <string>
+#include <utility>
 #include <vector>
 #include <ctime>
-#include <unordered_map>
+#include "rng.hpp"
 
+struct Cell {
+  std::uint8_t is_mine : 1 = false;     ///< Indicates if the cell contains a mine.
+  std::uint8_t is_revealed : 1 = false; ///< Indicates if the cell has been revealed.
+  std::uint8_t is_flagged : 1 = false;  ///< Indicates if the cell is flagged.
+  std::uint8_t safe_start : 1 = false;  ///< For no guess games, the place for a user to
+                                        ///< safely start a game.
+  std::uint8_t adjacent_mines : 4 = 0;  ///< Number of adjacent mines.
+};
+
+static_assert(sizeof(Cell) == 1, "Cell is expected to pack into one byte");
 
+/**
+ * @brief A Minesweeper board stored as one contiguous row-major array.
+ *
+ * The playing field is surrounded by a one cell border of sentinel cells. A
+ * sentinel is revealed, never a mine and never flagged, so any loop over the 8
+ * neighbours of a playing cell can index straight into the array without bounds
+ * checks: revealing, flagging or counting a sentinel is always a no-op.
+ *
+ * Cells can be addressed either by (row, col) in playing field coordinates or
+ * by their padded index, see index(), which is what the neighbour offsets are
+ * expressed in.
+ *
+ * The board keeps counts of mines, revealed cells and correct flags so that
+ * win, loss and remaining mine queries are O(1). The is_mine, is_revealed and
+ * is_flagged bits of playing cells must therefore be changed through
+ * set_mine(), reveal() and set_flagged(), or followed by recount().
+ */
+class Board {
+public:
+  Board() = default;
 
-// Define Direction enum class
-enum class Direction { up, down, left, right };
+  /**
+   * @brief Creates an empty board of the given size surrounded by sentinels.
+   *
+   * @param height Number of rows in the playing field.
+   * @param width Number of columns in the playing field.
+   */
+  Board(int height, int width);
 
-struct Cell {
-  bool is_mine = false;     ///< Indicates if the cell contains a mine.
-  bool is_revealed = false; ///< Indicates if the cell has been revealed.
-  bool is_flagged = false;  ///< Indicates if the cell is flagged.
-  bool safe_start = false;  ///< For no guess games, the place for a user to
-                            ///< safely start a game.
-  int adjacent_mines = 0;   ///< Number of adjacent mines.
-};
+  int height() const { return height_; }
+  int width() const { return width_; }
+
+  /**
+   * @brief Number of cells in the playing field, sentinels excluded.
+   */
+  int cell_count() const { return height_ * width_; }
+
+  /**
+   * @brief Number of cells in the padded array, sentinels included.
+   */
+  int padded_size() const { return static_cast<int>(cells_.size()); }
+
+  /**
+   * @brief Distance in the padded array between two vertically adjacent cells.
+   */
+  int stride() const { return width_ + 2; }
+
+  /**
+   * @brief Converts playing field coordinates to a padded index.
+   *
+   * Coordinates one step outside of the playing field are valid and refer to
+   * sentinel cells.
+   */
+  int index(int row, int col) const { return (row + 1) * stride() + col + 1; }
+  int row_of(int index) const { return index / stride() - 1; }
+  int col_of(int index) const { return index % stride() - 1; }
+
+  bool in_bounds(int row, int col) const {
+    return row >= 0 && row < height_ && col >= 0 && col < width_;
+  }
+
+  /**
+   * @brief Offsets which take a padded index to each of its 8 neighbours.
+   */
+  const std::array<int, 8> &neighbour_offsets() const { return offsets_; }
+
+  Cell &operator[](int index) { return cells_[index]; }
+  const Cell &operator[](int index) const { return cells_[index]; }
+
+  Cell &at(int row, int col) { return cells_[index(row, col)]; }
+  const Cell &at(int row, int col) const { return cells_[index(row, col)]; }
+
+  /**
+   * @brief The padded array, for kernels which index it directly. Writes to
+   * it follow the same rules as operator[].
+   */
+  Cell *data() { return cells_.data(); }
+  const Cell *data() const { return cells_.data(); }
 
+  bool empty() const { return cell_count() == 0; }
 
-using Board = std::vector<std::vector<Cell>>;
+  /**
+   * @brief Reveals a cell without flooding, see reveal_cell() for the game move.
+   */
+  void reveal(int index) {
+    Cell &cell = cells_[index];
+    if (!cell.is_revealed) {
+      cell.is_revealed = true;
+      (cell.is_mine ? revealed_mines_ : revealed_safe_) += 1;
+    }
+  }
+
+  void set_flagged(int index, bool flagged) {
+    Cell &cell = cells_[index];
+    if (cell.is_flagged != flagged) {
+      cell.is_flagged = flagged;
+      if (cell.is_mine) {
+        correct_flags_ += flagged ? 1 : -1;
+      }
+    }
+  }
+
+  void set_mine(int index, bool mine) {
+    Cell &cell = cells_[index];
+    if (cell.is_mine != mine) {
+      int delta = mine ? 1 : -1;
+      cell.is_mine = mine;
+      mine_count_ += delta;
+      if (cell.is_flagged) {
+        correct_flags_ += delta;
+      }
+      if (cell.is_revealed) {
+        revealed_mines_ += delta;
+        revealed_safe_ -= delta;
+      }
+    }
+  }
+
+  /**
+   * @brief Recomputes the counters after cells were written directly.
+   */
+  void recount();
+
+  int mine_count() const { return mine_count_; }
+
+  /**
+   * @brief Number of mines which are not flagged.
+   */
+  int unflagged_mines() const { return mine_count_ - correct_flags_; }
+
+  /**
+   * @brief True once a mine has been revealed.
+   */
+  bool mine_revealed() const { return revealed_mines_ > 0; }
+
+  /**
+   * @brief True when every safe cell is revealed and every mine is flagged.
+   */
+  bool is_field_clear() const {
+    return revealed_safe_ == cell_count() - mine_count_ &&
+           correct_flags_ == mine_count_;
+  }
+
+private:
+  int height_ = 0;
+  int width_ = 0;
+  int mine_count_ = 0;
+  int revealed_safe_ = 0;  ///< Revealed playing cells which are not mines.
+  int revealed_mines_ = 0;
+  int correct_flags_ = 0;  ///< Flagged playing cells which are mines.
+  std::array<int, 8> offsets_{};
+  std::vector<Cell> cells_;
+};
 
 /**
- * @brief Reads a Minesweeper board from a file and generates a 2D vector of Cell objects.
+ * @brief Reads the next text board from a stream of boards separated by blank
+ * lines, in the format of read_board_from_file().
+ *
+ * @return The board and the number of mines on it, std::nullopt once the
+ *         stream holds no more boards.
+ * @throws std::runtime_error if the rows of the board differ in length.
+ */
+std::optional<std::pair<Board, int>> read_board_from_stream(std::istream &in);
+
+/**
+ * @brief Reads a Minesweeper board from a file and generates a Board of Cell objects.
  *
  * This function reads the board from the given file, where each cell is represented by either 
  * a number (indicating the count of adjacent mines) or the letter "M" (indicating a mine). 
- * The function then constructs a 2D vector of `Cell` objects, where each `Cell` is initialized 
- * according to the contents of the file.
+ * The function then constructs a `Board` of `Cell` objects, where each `Cell` is initialized 
+ * according to the contents of the file. Only the first board is read if the
+ * file holds several separated by blank lines, see read_board_from_stream().
  *
  * @param filename The path to the file containing the Minesweeper board.
- * @return A 2D vector of `Cell` objects representing the Minesweeper board.
+ * @return The Minesweeper board and the number of mines on it.
  * @throws std::runtime_error if the file cannot be opened.
  *
  * Example file content:
@@ -47,152 +211,133 @@ using Board = std::vector<std::vector<Cell>>;
  *
  * Example usage:
  * @code
- * std::vector<std::vector<Cell>> board = read_board_from_file("minesweeper_board.txt");
+ * auto [board, mine_count] = read_board_from_file("minesweeper_board.txt");
  * @endcode
  */
 std::pair<Board, int> read_board_from_file(const std::string& filename);
 
 /**
- * @brief Initializes the Minesweeper board with mines and adjacent mine
- * counts.
- *
- * @param board 2D vector representing the Minesweeper board.
- * @param mines_count Number of mines to place on the board.
+ * @brief Fills in adjacent_mines for every safe cell from the placed mines.
  */
-Board generate_board(int mines_count, int height, int width);
-
+void count_adjacent_mines(Board &board);
 
 /**
- * @brief Initializes the ncurses environment and color pairs.
- */
-void initialize_ncurses();
-
-/**
- * @brief Gets the color pair for a specific number and cursor state.
+ * @brief Initializes the Minesweeper board with mines and adjacent mine
+ * counts.
  *
- * @param number The number on the cell (0-8) or special value for mine or flag.
- * @param is_cursor Boolean flag indicating if the cell is under the cursor.
+ * The mines are a partial Fisher-Yates sample of the cells, so placing them
+ * costs one draw per mine, and equal seeds give equal boards.
  *
- * @return The color pair number.
+ * @param mines_count Number of mines to place, at most every cell is mined.
+ * @param rng The random engine used to place the mines, each thread that
+ *            generates boards should own one.
  */
-int get_color_pair(int number, bool is_cursor);
+Board generate_board(int mines_count, int height, int width, Rng &rng);
 
 
 /**
- * @brief Displays the Minesweeper board with colored cells and cursor.
+ * @brief Reveals a cell on the Minesweeper board and floods out from it.
+ *
+ * This function reveals the specified cell and, if it has no adjacent mines,
+ * reveals its neighboring cells, continuing from each of them. If the number of
+ * adjacent mines equals the number of adjacent flags, it reveals all
+ * non-flagged squares around it. The flood is iterative, so its depth is not
+ * limited by the stack.
  *
- * @param board 2D vector representing the Minesweeper board.
- * @param cursor_row Current row of the cursor.
- * @param cursor_col Current column of the cursor.
+ * @param board The Minesweeper board.
+ * @param row Row index of the cell to reveal.
+ * @param col Column index of the cell to reveal.
+ *
+ * @return True if the cell was revealed successfully, false if a mine was hit.
  */
-void display_board(const std::vector<std::vector<Cell>> &board, int cursor_row,
-                   int cursor_col); 
+bool reveal_cell(Board &board, int row, int col);
+
 /**
- * @brief Reveals a cell on the Minesweeper board recursively.
+ * @brief Reveals a cell like reveal_cell() and reports what changed.
  *
- * This function reveals the specified cell and, if it has no adjacent mines,
- * recursively reveals its neighboring cells. If the number of adjacent mines
- * equals the number of adjacent flags, it reveals all non-flagged squares
- * around it.
- *
- * @param board 2D vector representing the Minesweeper board.
+ * @param board The Minesweeper board.
  * @param row Row index of the cell to reveal.
  * @param col Column index of the cell to reveal.
+ * @param revealed Cleared, then filled with the padded index of every newly
+ *                 revealed cell. Its storage is reused as the flood's work
+ *                 queue, so passing the same vector each time avoids
+ *                 allocating.
  *
  * @return True if the cell was revealed successfully, false if a mine was hit.
  */
-bool reveal_cell(std::vector<std::vector<Cell>> &board, int row, int col);
+bool reveal_cell(Board &board, int row, int col, std::vector<int> &revealed);
 
 /**
  * @brief Reveals all adjacent cells of a specified cell on the Minesweeper
  * board.
  *
- * @param board 2D vector representing the Minesweeper board.
+ * @param board The Minesweeper board.
  * @param row Row index of the center cell.
  * @param col Column index of the center cell.
+ *
+ * @return True if no mine was hit.
  */
-bool reveal_adjacent_cells(std::vector<std::vector<Cell>> &board, int row,
+bool reveal_adjacent_cells(Board &board, int row,
                            int col);
 
+/**
+ * @brief Reveals all adjacent cells of a specified cell and reports what changed.
+ *
+ * @param board The Minesweeper board.
+ * @param row Row index of the center cell.
+ * @param col Column index of the center cell.
+ * @param revealed Cleared, then filled with the padded index of every newly revealed cell.
+ *
+ * @return True if no mine was hit.
+ */
+bool reveal_adjacent_cells(Board &board, int row, int col,
+                           std::vector<int> &revealed);
+
 /**
  * @brief Flags or unflags a cell on the Minesweeper board.
  *
- * @param board 2D vector representing the Minesweeper board.
+ * @param board The Minesweeper board.
  * @param row Row index of the cell to flag or unflag.
  * @param col Column index of the cell to flag or unflag.
+ *
+ * @return True if the flag of the cell changed.
  */
-void toggle_flag_cell(std::vector<std::vector<Cell>> &board, int row, int col);
+bool toggle_flag_cell(Board &board, int row, int col);
 /**
  * @brief Flags a cell on the Minesweeper board.
  *
- * @param board 2D vector representing the Minesweeper board.
+ * @param board The Minesweeper board.
  * @param row Row index of the cell to flag
  * @param col Column index of the cell to flag
+ *
+ * @return True if the cell was not flagged before.
  */
-void flag_cell(std::vector<std::vector<Cell>> &board, int row, int col);
+bool flag_cell(Board &board, int row, int col);
 
 /**
  * @brief Flags all adjacent cells of a specified cell on the Minesweeper board.
  *
- * @param board 2D vector representing the Minesweeper board.
+ * @param board The Minesweeper board.
  * @param row Row index of the center cell.
  * @param col Column index of the center cell.
  */
-void flag_adjacent_cells(std::vector<std::vector<Cell>> &board, int row,
+void flag_adjacent_cells(Board &board, int row,
                          int col); 
-/**
- * @brief If the minefield has successfully been cleared
- */
-bool field_clear(std::vector<std::vector<Cell>> &board); 
-/**
- * @brief Displays the help text for the command-line Minesweeper game.
- */
-void display_help(); 
-using KeyMap = std::unordered_map<Direction, int>;
-
-// Vim-style map for direction keys
-/* KeyMap vim_map = {{Direction::up, static_cast<int>('k')}, */
-/*                   {Direction::down, static_cast<int>('j')}, */
-/*                   {Direction::left, static_cast<int>('h')}, */
-/*                   {Direction::right, static_cast<int>('l')}}; */
-
-// Function to create action map with captured variables
-auto create_action_map(int &cursor_row, int &cursor_col,
-                       std::vector<std::vector<Cell>> &board, bool &game_over,
-                       int height, int width, int mines_count, bool &vim);
-
 
 /**
- * @brief Handles command-line arguments for the Minesweeper game.
- *
- * This function parses command-line arguments to set game parameters such as board width, height,
- * mine count, and additional flags like `no_guess` and `vim`. It also allows the user to specify
- * a minefield file to load a predefined board.
- *
- * @param argc The number of command-line arguments.
- * @param argv The array of command-line arguments.
- * @param width Reference to the variable holding the width of the board.
- * @param height Reference to the variable holding the height of the board.
- * @param mines_count Reference to the variable holding the number of mines.
- * @param no_guess Reference to the boolean flag that disables guessing.
- * @param vim Reference to the boolean flag that enables Vim keybindings.
- * @param file_path Reference to the string variable holding the path to the minefield file.
- * @return `true` if an early return is required (e.g., when `--help` is invoked), otherwise `false`.
+ * @brief Flags all adjacent cells of a specified cell and reports what changed.
+ *
+ * @param board The Minesweeper board.
+ * @param row Row index of the center cell.
+ * @param col Column index of the center cell.
+ * @param flagged Cleared, then filled with the padded index of every newly flagged cell.
  */
-bool handle_command_line_args(int argc, char *argv[], int &width, int &height,
-                              int &mines_count, bool&no_guess, bool&vim, std::string &file_path);
-
+void flag_adjacent_cells(Board &board, int row, int col,
+                         std::vector<int> &flagged);
 /**
- * @brief Main function for the Minesweeper game.
- *
- * Handles command-line arguments and manages the game loop.
- *
- * @param argc Number of command-line arguments.
- * @param argv Array of command-line arguments.
- *
- * @return Exit status code.
+ * @brief If the minefield has successfully been cleared, O(1) through the
+ * board's counters
  */
-int start_game(int argc, char *argv[]);
-
+bool field_clear(Board &board); 
 
 #endif //GAME_LOGIC_HPP
@@ -1,7 +1,10 @@
 #include "linear_system_solver.hpp"
 #include <algorithm>
+#include <bit>
 #include <iomanip>
 #include <iostream>
+#include <limits>
+#include <numeric>
 #include <set>
 #include <unordered_map>
 #include <vector>
@@ -37,202 +40,762 @@ create_augmented_matrix(const set<LinearEquation> &equations,
   return augmented_matrix;
 }
 
-void gaussian_elimination(vector<vector<int>> &augmented_matrix,
-                          int num_variables, bool enable_logging) {
-  // Convert the integer matrix to a floating-point matrix
-  std::vector<std::vector<float>> A(
-      augmented_matrix.size(),
-      std::vector<float>(augmented_matrix.at(0).size()));
+vector<SparseSystem> split_into_components(const SparseSystem &system) {
+  int num_variables = system.num_variables();
+  vector<int> parent(num_variables);
+  iota(parent.begin(), parent.end(), 0);
 
-  for (size_t i = 0; i < augmented_matrix.size(); ++i) {
-    for (size_t j = 0; j < augmented_matrix[i].size(); ++j) {
-      A[i][j] = static_cast<float>(augmented_matrix[i][j]);
+  auto find_root = [&](int var) {
+    while (parent[var] != var) {
+      parent[var] = parent[parent[var]];
+      var = parent[var];
+    }
+    return var;
+  };
+
+  // Every row joins all of its variables into one component
+  for (int row = 0; row < system.num_equations(); ++row) {
+    int begin = system.row_offsets[row];
+    for (int k = begin + 1; k < system.row_offsets[row + 1]; ++k) {
+      parent[find_root(system.columns[k])] = find_root(system.columns[begin]);
     }
   }
 
-  int row_count = A.size();       // number of rows
-  int column_count = A[0].size(); // number of columns
-  int lead = 0; // This will track the leading column for the pivot element
+  vector<SparseSystem> components;
+  vector<int> component_of_root(num_variables, -1);
+  vector<int> local_id(num_variables);
 
-  for (int r = 0; r < row_count; ++r) {
-    if (lead >= column_count) {
-      return;
+  for (int var = 0; var < num_variables; ++var) {
+    int root = find_root(var);
+    if (component_of_root[root] == -1) {
+      component_of_root[root] = components.size();
+      components.emplace_back();
+    }
+    SparseSystem &component = components[component_of_root[root]];
+    local_id[var] = component.num_variables();
+    component.variable_cells.push_back(system.variable_cells[var]);
+  }
+
+  for (int row = 0; row < system.num_equations(); ++row) {
+    int begin = system.row_offsets[row];
+    int end = system.row_offsets[row + 1];
+    if (begin == end) {
+      continue;
     }
+    SparseSystem &component =
+        components[component_of_root[find_root(system.columns[begin])]];
+    for (int k = begin; k < end; ++k) {
+      component.columns.push_back(local_id[system.columns[k]]);
+    }
+    component.end_row(system.target_sums[row]);
+  }
+
+  return components;
+}
+
+vector<vector<int>> create_augmented_matrix(const SparseSystem &system) {
+  int num_variables = system.num_variables();
+  vector<vector<int>> augmented_matrix(system.num_equations(),
+                                       vector<int>(num_variables + 1, 0));
 
+  for (int row = 0; row < system.num_equations(); ++row) {
+    for (int k = system.row_offsets[row]; k < system.row_offsets[row + 1];
+         ++k) {
+      augmented_matrix[row][system.columns[k]] = 1;
+    }
+    augmented_matrix[row][num_variables] = system.target_sums[row];
+  }
+
+  return augmented_matrix;
+}
+
+// Divides a row by the gcd of its entries and makes its leading coefficient
+// positive, which keeps fraction free elimination from growing the entries
+static void normalize_row(vector<int> &row) {
+  int divisor = 0;
+  for (int value : row) {
+    divisor = gcd(divisor, value);
+    if (divisor == 1) {
+      break;
+    }
+  }
+  auto lead = find_if(row.begin(), row.end(), [](int v) { return v != 0; });
+  if (lead != row.end() && *lead < 0) {
+    divisor = -divisor;
+  }
+  if (divisor != 0 && divisor != 1) {
+    for (int &value : row) {
+      value /= divisor;
+    }
+  }
+}
+
+// row = pivot * row - factor * pivot_row, exactly, in 64 bits. Returns false
+// and leaves row as it was when an entry would not fit an int
+static bool eliminate(vector<int> &row, const vector<int> &pivot_row,
+                      int pivot, int factor, vector<long long> &scratch) {
+  constexpr long long limit = numeric_limits<int>::max();
+  scratch.resize(row.size());
+  for (size_t c = 0; c < row.size(); ++c) {
+    long long value = static_cast<long long>(pivot) * row[c] -
+                      static_cast<long long>(factor) * pivot_row[c];
+    if (value > limit || value < -limit) {
+      return false;
+    }
+    scratch[c] = value;
+  }
+  for (size_t c = 0; c < row.size(); ++c) {
+    row[c] = static_cast<int>(scratch[c]);
+  }
+  normalize_row(row);
+  return true;
+}
+
+void gaussian_elimination(vector<vector<int>> &augmented_matrix,
+                          int num_variables, bool enable_logging) {
+  int row_count = augmented_matrix.size();
+  int r = 0;
+  vector<long long> scratch;
+
+  for (int lead = 0; lead < num_variables && r < row_count; ++lead) {
     int i = r;
-    while (A[i][lead] == 0) {
+    while (i < row_count && augmented_matrix[i][lead] == 0) {
       i++;
-      if (i == row_count) {
-        i = r;
-        lead++;
-        if (lead == column_count) {
-          return;
-        }
+    }
+    if (i == row_count) {
+      continue;
+    }
+    swap(augmented_matrix[i], augmented_matrix[r]);
+    normalize_row(augmented_matrix[r]);
+
+    // Cross multiplying instead of dividing by the pivot keeps every entry an
+    // integer. A row whose entries would overflow keeps its lead, it is still
+    // a combination of the input rows so deductions from it stay sound
+    const vector<int> &pivot_row = augmented_matrix[r];
+    int pivot = pivot_row[lead];
+    for (int k = 0; k < row_count; ++k) {
+      int factor = augmented_matrix[k][lead];
+      if (k != r && factor != 0) {
+        int common = gcd(pivot, factor);
+        eliminate(augmented_matrix[k], pivot_row, pivot / common,
+                  factor / common, scratch);
       }
     }
+    r++;
 
-    // Swap rows i and r
-    std::swap(A[i], A[r]);
+    if (enable_logging) {
+      std::cout << "After processing row " << r << ":" << std::endl;
+      print_matrix(augmented_matrix);
+    }
+  }
+}
 
-    // Normalize the pivot row
-    float lead_value = A[r][lead];
-    if (lead_value != 0) {
-      for (int c = 0; c < column_count; ++c) {
-        A[r][c] /= lead_value;
+unordered_map<int, int>
+deduce_variables(const vector<vector<int>> &augmented_matrix, int num_variables,
+                 bool enable_logging) {
+  vector<signed char> values(num_variables, -1);
+  unordered_map<int, int> deduced;
+
+  // Bounds reasoning: with the known values substituted, the unknown part of
+  // a row ranges over [lowest, highest], the sums of its negative and of its
+  // positive coefficients. A variable whose other value would push the row
+  // outside of that range once the target is fixed must take this one. This
+  // covers rows of mixed signs, the zero and full sum rules and rows with a
+  // single unknown. A value can make other rows decidable, so the rows are
+  // swept until nothing changes.
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (int i = static_cast<int>(augmented_matrix.size()) - 1; i >= 0; i--) {
+      const vector<int> &row = augmented_matrix[i];
+      long long target = row[num_variables];
+      long long lowest = 0;
+      long long highest = 0;
+      for (int j = 0; j < num_variables; j++) {
+        if (row[j] == 0) {
+          continue;
+        }
+        if (values[j] != -1) {
+          target -= static_cast<long long>(row[j]) * values[j];
+        } else if (row[j] < 0) {
+          lowest += row[j];
+        } else {
+          highest += row[j];
+        }
+      }
+      if (target < lowest || target > highest || lowest == highest) {
+        continue; // inconsistent, or nothing unknown left
       }
-    }
 
-    // Subtract M[i, lead] multiplied by row r from row i
-    for (int i = 0; i < row_count; ++i) {
-      if (i != r) {
-        float mult = A[i][lead];
-        for (int c = 0; c < column_count; ++c) {
-          A[i][c] -= mult * A[r][c];
+      for (int j = 0; j < num_variables && lowest != highest; j++) {
+        int coefficient = row[j];
+        if (coefficient == 0 || values[j] != -1) {
+          continue;
+        }
+        // Range of the rest of the row without v_j
+        long long rest_lowest = coefficient < 0 ? lowest - coefficient : lowest;
+        long long rest_highest = coefficient > 0 ? highest - coefficient : highest;
+        bool one_fits = rest_lowest <= target - coefficient &&
+                        target - coefficient <= rest_highest;
+        bool zero_fits = rest_lowest <= target && target <= rest_highest;
+        if (one_fits == zero_fits) {
+          continue;
+        }
+
+        int value = one_fits ? 1 : 0;
+        values[j] = value;
+        deduced[j] = value;
+        changed = true;
+        target -= value * coefficient;
+        lowest = rest_lowest;
+        highest = rest_highest;
+        if (enable_logging) {
+          cout << "Deduced variable v" << j << " = " << value
+               << " by the bounds of equation " << i << endl;
         }
       }
     }
+  }
 
-    lead++;
+  return deduced;
+}
 
-    if (enable_logging) {
-      std::cout << "After processing row " << r + 1 << ":" << std::endl;
-      print_matrix(A);
+static int words_for(int num_variables) { return (num_variables + 63) / 64; }
+
+// Makes sure row stores the words [first_word, end_word)
+static void widen_row(BitsetRow &row, int first_word, int end_word) {
+  int row_end = row.first_word + static_cast<int>(row.positive.size());
+  if (row.positive.empty()) {
+    row.first_word = first_word;
+    row_end = first_word;
+  }
+  int new_first = min(row.first_word, first_word);
+  int new_end = max(row_end, end_word);
+  if (new_first == row.first_word && new_end == row_end) {
+    return;
+  }
+  // Widen in place so a reused row only allocates when it outgrows its storage
+  int old_words = static_cast<int>(row.positive.size());
+  int shift = row.first_word - new_first;
+  for (vector<uint64_t> *words : {&row.positive, &row.negative}) {
+    words->resize(new_end - new_first, 0);
+    if (shift > 0) {
+      copy_backward(words->begin(), words->begin() + old_words,
+                    words->begin() + shift + old_words);
+      fill(words->begin(), words->begin() + shift, 0);
     }
   }
-  // Copy the results back to the original matrix, truncating the float to int
-  for (int i = 0; i < row_count; ++i) {
-    for (int j = 0; j < column_count; ++j) {
-      augmented_matrix[i][j] =
-          static_cast<int>(A[i][j]); // Truncate the floating-point value
+  row.first_word = new_first;
+}
+
+// Coefficient (-1, 0 or 1) of variable var in row
+static int coefficient(const BitsetRow &row, int var) {
+  int k = var / 64 - row.first_word;
+  if (k < 0 || k >= static_cast<int>(row.positive.size())) {
+    return 0;
+  }
+  uint64_t bit = uint64_t{1} << (var % 64);
+  if (row.positive[k] & bit) {
+    return 1;
+  }
+  if (row.negative[k] & bit) {
+    return -1;
+  }
+  return 0;
+}
+
+// dst += sign * src, fails without touching dst when a coefficient would
+// leave {-1, 0, 1}
+static bool add_row(BitsetRow &dst, const BitsetRow &src, int sign) {
+  const vector<uint64_t> &src_pos = sign > 0 ? src.positive : src.negative;
+  const vector<uint64_t> &src_neg = sign > 0 ? src.negative : src.positive;
+  int src_words = static_cast<int>(src_pos.size());
+  int dst_words = static_cast<int>(dst.positive.size());
+
+  for (int k = 0; k < src_words; ++k) {
+    int dst_k = src.first_word + k - dst.first_word;
+    if (dst_k < 0 || dst_k >= dst_words) {
+      continue;
     }
+    uint64_t overflow = (dst.positive[dst_k] & src_pos[k]) |
+                        (dst.negative[dst_k] & src_neg[k]);
+    if (overflow) {
+      return false;
+    }
+  }
+
+  widen_row(dst, src.first_word, src.first_word + src_words);
+  int offset = src.first_word - dst.first_word;
+  for (int k = 0; k < src_words; ++k) {
+    uint64_t p = dst.positive[offset + k];
+    uint64_t n = dst.negative[offset + k];
+    uint64_t a = src_pos[k];
+    uint64_t b = src_neg[k];
+    // +1 and -1 cancel, anything next to a 0 is kept
+    dst.positive[offset + k] = (p & ~b) | (a & ~n);
+    dst.negative[offset + k] = (n & ~a) | (b & ~p);
   }
+  dst.target_sum += sign * src.target_sum;
+  return true;
 }
 
-unordered_map<int, int>
-deduce_variables(const vector<vector<int>> &augmented_matrix, int num_variables,
-                 bool enable_logging) {
+static void print_bitset_row(const BitsetRow &row) {
+  for (int k = 0; k < static_cast<int>(row.positive.size()); ++k) {
+    for (int b = 0; b < 64; ++b) {
+      uint64_t bit = uint64_t{1} << b;
+      int var = (row.first_word + k) * 64 + b;
+      if (row.positive[k] & bit) {
+        cout << "+v" << var << " ";
+      } else if (row.negative[k] & bit) {
+        cout << "-v" << var << " ";
+      }
+    }
+  }
+  cout << "= " << row.target_sum << endl;
+}
 
-  // Map to store deduced values of variables.
-  unordered_map<int, int> var_name_to_deduced_value;
+BitsetMatrix create_bitset_matrix(const set<LinearEquation> &equations,
+                                  int num_variables) {
+  BitsetMatrix matrix;
+  matrix.reserve(equations.size());
+
+  for (const auto &equation : equations) {
+    BitsetRow row;
+    row.target_sum = equation.target_sum;
+    if (!equation.variables.empty()) {
+      // variables are sorted by normalize()
+      int first_word = equation.variables.front() / 64;
+      int end_word = equation.variables.back() / 64 + 1;
+      widen_row(row, first_word, end_word);
+      for (int var : equation.variables) {
+        row.positive[var / 64 - first_word] |= uint64_t{1} << (var % 64);
+      }
+    }
+    matrix.push_back(std::move(row));
+  }
 
-  // Number of equations in the augmented matrix.
-  int num_equations = augmented_matrix.size();
+  return matrix;
+}
 
-  // Logging to indicate the start of back substitution if enabled.
-  if (enable_logging) {
-    cout << "Starting back substitution:" << endl;
+BitsetMatrix create_bitset_matrix(const SparseSystem &system) {
+  BitsetMatrix matrix(system.num_equations());
+
+  for (int r = 0; r < system.num_equations(); ++r) {
+    BitsetRow &row = matrix[r];
+    row.target_sum = system.target_sums[r];
+
+    int begin = system.row_offsets[r];
+    int end = system.row_offsets[r + 1];
+    if (begin == end) {
+      continue;
+    }
+    auto [lowest, highest] = minmax_element(system.columns.begin() + begin,
+                                            system.columns.begin() + end);
+    int first_word = *lowest / 64;
+    widen_row(row, first_word, *highest / 64 + 1);
+    for (int k = begin; k < end; ++k) {
+      int var = system.columns[k];
+      row.positive[var / 64 - first_word] |= uint64_t{1} << (var % 64);
+    }
   }
 
-  // Iterate over each equation starting from the last one (back substitution).
-  for (int i = num_equations - 1; i >= 0; i--) {
-    if (enable_logging) {
-      cout << "Processing equation " << i << endl;
+  return matrix;
+}
+
+void gaussian_elimination(BitsetMatrix &matrix, int num_variables,
+                          bool enable_logging) {
+  vector<char> is_pivot_column(words_for(num_variables) * 64, 0);
+  int row_count = matrix.size();
+
+  for (int r = 0; r < row_count; ++r) {
+    BitsetRow &pivot_row = matrix[r];
+
+    // The pivot is the lowest variable of the row that is not already a pivot
+    int pivot = -1;
+    for (int k = 0; k < static_cast<int>(pivot_row.positive.size()) &&
+                    pivot == -1;
+         ++k) {
+      uint64_t word = pivot_row.positive[k] | pivot_row.negative[k];
+      while (word) {
+        int var = (pivot_row.first_word + k) * 64 + countr_zero(word);
+        if (!is_pivot_column[var]) {
+          pivot = var;
+          break;
+        }
+        word &= word - 1;
+      }
     }
 
-    auto row = augmented_matrix[i];
+    if (pivot == -1) {
+      continue;
+    }
+
+    // Normalize the pivot row so the pivot has coefficient +1
+    if (coefficient(pivot_row, pivot) < 0) {
+      swap(pivot_row.positive, pivot_row.negative);
+      pivot_row.target_sum = -pivot_row.target_sum;
+    }
+    is_pivot_column[pivot] = 1;
+
+    // Eliminate the pivot column from every other row
+    for (int i = 0; i < row_count; ++i) {
+      if (i == r) {
+        continue;
+      }
+      int c = coefficient(matrix[i], pivot);
+      if (c != 0) {
+        add_row(matrix[i], pivot_row, -c);
+      }
+    }
 
-    // Start with the sum on the right-hand side of the equation.
-    int sum = row[num_variables];
     if (enable_logging) {
-      cout << "Initial sum (right-hand side) for equation " << i << ": " << sum
+      cout << "After pivoting on v" << pivot << " in row " << r + 1 << ":"
            << endl;
+      for (const auto &row : matrix) {
+        print_bitset_row(row);
+      }
     }
+  }
+}
 
-    // To track which variable might be deduced in this row.
-    int variable_index = -1;
+unordered_map<int, int> deduce_variables(const BitsetMatrix &matrix,
+                                         int num_variables,
+                                         bool enable_logging) {
+  unordered_map<int, int> var_name_to_deduced_value;
+  vector<signed char> values(words_for(num_variables) * 64, -1);
 
-    // To count the number of non-zero coefficients in the current equation.
-    int non_zero_coeff_count = 0;
+  if (enable_logging) {
+    cout << "Starting bitset deduction:" << endl;
+  }
 
-    // Iterate through all the variables in the current equation.
-    for (int j = 0; j < num_variables; j++) {
-      // If the coefficient is non-zero.
-      int coefficient = row[j];
-      bool coefficient_is_nonzero = coefficient != 0;
-      if (coefficient_is_nonzero) {
-        non_zero_coeff_count++;
-        if (enable_logging) {
-          cout << "Non-zero coefficient found at index " << j << ": "
-               << coefficient << endl;
+  // Keep sweeping while deductions unlock further deductions, rows are not
+  // ordered by pivot so a single back substitution pass is not enough
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (int i = static_cast<int>(matrix.size()) - 1; i >= 0; i--) {
+      const BitsetRow &row = matrix[i];
+      int sum = row.target_sum;
+      int unknown_positive = 0;
+      int unknown_negative = 0;
+
+      for (int k = 0; k < static_cast<int>(row.positive.size()); ++k) {
+        for (uint64_t word = row.positive[k]; word; word &= word - 1) {
+          int var = (row.first_word + k) * 64 + countr_zero(word);
+          if (values[var] == -1) {
+            unknown_positive++;
+          } else {
+            sum -= values[var];
+          }
+        }
+        for (uint64_t word = row.negative[k]; word; word &= word - 1) {
+          int var = (row.first_word + k) * 64 + countr_zero(word);
+          if (values[var] == -1) {
+            unknown_negative++;
+          } else {
+            sum += values[var];
+          }
         }
+      }
+
+      if (unknown_positive + unknown_negative == 0) {
+        continue;
+      }
+
+      // The left-hand side ranges over [-unknown_negative, unknown_positive],
+      // hitting either end fixes every unknown in the row
+      int positive_value;
+      if (sum == unknown_positive) {
+        positive_value = 1;
+      } else if (sum == -unknown_negative) {
+        positive_value = 0;
+      } else {
+        continue;
+      }
+
+      if (enable_logging) {
+        cout << "Row " << i << " is at a bound, sum " << sum << endl;
+      }
 
-        // Check if the current variable has not been deduced yet.
-        bool not_yet_deduced = var_name_to_deduced_value.find(j) ==
-                               var_name_to_deduced_value.end();
-        if (not_yet_deduced) {
-          variable_index = j; // Possible variable to deduce.
-          if (enable_logging) {
-            cout << "Variable v" << j << " might be deduced" << endl;
+      for (int k = 0; k < static_cast<int>(row.positive.size()); ++k) {
+        for (uint64_t word = row.positive[k]; word; word &= word - 1) {
+          int var = (row.first_word + k) * 64 + countr_zero(word);
+          if (values[var] == -1) {
+            values[var] = positive_value;
+            var_name_to_deduced_value[var] = positive_value;
           }
-        } else {
-          auto deduced_value = var_name_to_deduced_value[j];
-          if (deduced_value != 0) {
-            // Subtracting from left and right side of the equation
-            sum -= coefficient * deduced_value;
-            if (enable_logging) {
-              cout << "Subtracting " << coefficient * deduced_value
-                   << " from sum, new sum: " << sum << endl;
-            }
+        }
+        for (uint64_t word = row.negative[k]; word; word &= word - 1) {
+          int var = (row.first_word + k) * 64 + countr_zero(word);
+          if (values[var] == -1) {
+            values[var] = 1 - positive_value;
+            var_name_to_deduced_value[var] = 1 - positive_value;
           }
         }
       }
+      changed = true;
     }
+  }
 
-    // Because coefficients are non-negative a zero sum means all the rest are
-    // zero
-    if (sum == 0 && non_zero_coeff_count >= 1) {
-      for (int j = 0; j < num_variables; j++) {
-        bool is_unassigned = var_name_to_deduced_value.find(j) ==
-                             var_name_to_deduced_value.end();
-        if (row[j] != 0 && is_unassigned) {
-          var_name_to_deduced_value[j] = 0;
-          if (enable_logging) {
-            cout << "Deduced variable v" << j << " = 0 by zero sum" << endl;
-          }
-        }
+  if (enable_logging) {
+    for (const auto &[var, value] : var_name_to_deduced_value) {
+      cout << "Deduced variable v" << var << " = " << value << endl;
+    }
+  }
+
+  return var_name_to_deduced_value;
+}
+
+// Calls f(var, coefficient) for every variable with a non-zero coefficient
+template <typename F>
+static void for_each_variable(const BitsetRow &row, F f) {
+  for (int k = 0; k < static_cast<int>(row.positive.size()); ++k) {
+    for (uint64_t word = row.positive[k] | row.negative[k]; word;
+         word &= word - 1) {
+      int b = countr_zero(word);
+      f((row.first_word + k) * 64 + b, (row.positive[k] >> b) & 1 ? 1 : -1);
+    }
+  }
+}
+
+void IncrementalSystem::reset(int num_variables) {
+  // Rows keep their words' storage, they are handed out again in index order
+  free_rows.clear();
+  for (int r = static_cast<int>(rows.size()) - 1; r >= 0; --r) {
+    rows[r].positive.clear();
+    rows[r].negative.clear();
+    rows[r].target_sum = 0;
+    pivot_of_row[r] = -1;
+    is_dirty[r] = 0;
+    free_rows.push_back(r);
+  }
+  dirty_rows.clear();
+  repivot_rows.clear();
+  row_of_pivot.assign(num_variables, -1);
+  values.assign(num_variables, -1);
+  if (static_cast<int>(rows_of_var.size()) < num_variables) {
+    rows_of_var.resize(num_variables);
+  }
+  for (auto &list : rows_of_var) {
+    list.clear();
+  }
+  live_variables = 0;
+}
+
+void IncrementalSystem::mark_dirty(int r) {
+  if (!is_dirty[r]) {
+    is_dirty[r] = 1;
+    dirty_rows.push_back(r);
+  }
+}
+
+void IncrementalSystem::release_row(int r) {
+  if (pivot_of_row[r] != -1) {
+    row_of_pivot[pivot_of_row[r]] = -1;
+    pivot_of_row[r] = -1;
+  }
+  rows[r].positive.clear();
+  rows[r].negative.clear();
+  rows[r].target_sum = 0;
+  free_rows.push_back(r);
+}
+
+bool IncrementalSystem::combine(int dst, int src, int sign) {
+  // Variables that src brings into dst, recorded only once the row operation
+  // is known to succeed
+  scratch.clear();
+  for_each_variable(rows[src], [&](int var, int) {
+    if (coefficient(rows[dst], var) == 0) {
+      scratch.push_back(var);
+    }
+  });
+  if (!add_row(rows[dst], rows[src], sign)) {
+    return false;
+  }
+  for (int var : scratch) {
+    live_variables += rows_of_var[var].empty();
+    rows_of_var[var].push_back(dst);
+  }
+  mark_dirty(dst);
+  return true;
+}
+
+void IncrementalSystem::reduce_row(int r) {
+  // Eliminate the existing pivots from the row, a pivot whose row operation
+  // overflows is left in place. Each pivot is tried once, which also stops
+  // pivot rows that were left unreduced from cycling.
+  tried.clear();
+  while (true) {
+    int pivot_var = -1;
+    int c = 0;
+    for_each_variable(rows[r], [&](int var, int coeff) {
+      if (pivot_var == -1 && row_of_pivot[var] != -1 &&
+          row_of_pivot[var] != r &&
+          find(tried.begin(), tried.end(), var) == tried.end()) {
+        pivot_var = var;
+        c = coeff;
       }
+    });
+    if (pivot_var == -1) {
+      break;
     }
+    tried.push_back(pivot_var);
+    combine(r, row_of_pivot[pivot_var], -c);
+  }
 
-    // Special case: if the sum equals the number of non-zero coefficients, all
-    // undetermined variables must be 1.
-    if (sum == non_zero_coeff_count && non_zero_coeff_count >= 1) {
-      for (int j = 0; j < num_variables; j++) {
-        if (row[j] != 0 && var_name_to_deduced_value.find(j) ==
-                               var_name_to_deduced_value.end()) {
-          var_name_to_deduced_value[j] = 1;
-          if (enable_logging) {
-            cout << "Deduced variable v" << j << " = 1 by equal sum" << endl;
-          }
-        }
+  // Pick the lowest free variable as the new pivot
+  int pivot = -1;
+  for_each_variable(rows[r], [&](int var, int) {
+    if (pivot == -1 && row_of_pivot[var] == -1) {
+      pivot = var;
+    }
+  });
+  if (pivot == -1) {
+    return;
+  }
+
+  if (coefficient(rows[r], pivot) < 0) {
+    swap(rows[r].positive, rows[r].negative);
+    rows[r].target_sum = -rows[r].target_sum;
+  }
+  pivot_of_row[r] = pivot;
+  row_of_pivot[pivot] = r;
+
+  // Eliminate the new pivot from every other row that holds it
+  holders.assign(rows_of_var[pivot].begin(), rows_of_var[pivot].end());
+  rows_of_var[pivot].clear();
+  rows_of_var[pivot].push_back(r);
+  for (int i : holders) {
+    if (i == r) {
+      continue;
+    }
+    int c = coefficient(rows[i], pivot);
+    if (c != 0 && !combine(i, r, -c)) {
+      rows_of_var[pivot].push_back(i);
+    }
+  }
+}
+
+void IncrementalSystem::add_equation(span<const int> variables,
+                                     int target_sum) {
+  if (variables.empty()) {
+    return;
+  }
+
+  int r;
+  if (!free_rows.empty()) {
+    r = free_rows.back();
+    free_rows.pop_back();
+  } else {
+    r = rows.size();
+    rows.emplace_back();
+    pivot_of_row.push_back(-1);
+    is_dirty.push_back(0);
+  }
+
+  BitsetRow &row = rows[r];
+  row.target_sum = target_sum;
+  auto [lowest, highest] = minmax_element(variables.begin(), variables.end());
+  row.positive.clear();
+  row.negative.clear();
+  widen_row(row, *lowest / 64, *highest / 64 + 1);
+  for (int var : variables) {
+    row.positive[var / 64 - row.first_word] |= uint64_t{1} << (var % 64);
+    live_variables += rows_of_var[var].empty();
+    rows_of_var[var].push_back(r);
+  }
+
+  reduce_row(r);
+  mark_dirty(r);
+}
+
+void IncrementalSystem::assign(int var, int value) {
+  if (values[var] != -1) {
+    return;
+  }
+  values[var] = value;
+
+  for (int r : rows_of_var[var]) {
+    int c = coefficient(rows[r], var);
+    if (c == 0) {
+      continue; // stale entry
+    }
+    BitsetRow &row = rows[r];
+    uint64_t bit = uint64_t{1} << (var % 64);
+    row.positive[var / 64 - row.first_word] &= ~bit;
+    row.negative[var / 64 - row.first_word] &= ~bit;
+    row.target_sum -= c * value;
+    if (pivot_of_row[r] == var) {
+      // the row needs a new pivot, deduce() re-reduces it
+      pivot_of_row[r] = -1;
+      repivot_rows.push_back(r);
+    }
+    mark_dirty(r);
+  }
+  live_variables -= !rows_of_var[var].empty();
+  rows_of_var[var].clear();
+  row_of_pivot[var] = -1;
+}
+
+const vector<pair<int, int>> &IncrementalSystem::deduce() {
+  deduced.clear();
+
+  while (!dirty_rows.empty() || !repivot_rows.empty()) {
+    // Rows which lost their pivot to an assignment are reduced again first
+    while (!repivot_rows.empty()) {
+      int r = repivot_rows.back();
+      repivot_rows.pop_back();
+      if (pivot_of_row[r] == -1 && !rows[r].positive.empty()) {
+        reduce_row(r);
+        mark_dirty(r);
       }
     }
+    if (dirty_rows.empty()) {
+      break;
+    }
 
-    // If there's exactly one undetermined variable in this equation.
-    if (non_zero_coeff_count == 1 && variable_index != -1) {
-      // Calculate the value of the undetermined variable by dividing the sum by
-      // the coefficient.
-      int deduced_value = sum / augmented_matrix[i][variable_index];
-      if (enable_logging) {
-        cout << "Deduced value for variable v" << variable_index << " = "
-             << deduced_value << " by row reduction isolation" << endl;
+    int r = dirty_rows.back();
+    dirty_rows.pop_back();
+    is_dirty[r] = 0;
+
+    BitsetRow &row = rows[r];
+    int unknown_positive = 0;
+    int unknown_negative = 0;
+    for (int k = 0; k < static_cast<int>(row.positive.size()); ++k) {
+      unknown_positive += popcount(row.positive[k]);
+      unknown_negative += popcount(row.negative[k]);
+    }
+
+    if (unknown_positive + unknown_negative == 0) {
+      // released rows have no words, so each row is only released once
+      if (!row.positive.empty()) {
+        release_row(r);
       }
+      continue;
+    }
 
-      // Ensure the deduced value is binary (0 or 1).
-      if (deduced_value == 0 || deduced_value == 1) {
-        // Store the deduced value in the map.
-        var_name_to_deduced_value[variable_index] = deduced_value;
-        if (enable_logging) {
-          cout << "Deduced value for variable v" << variable_index << " = "
-               << deduced_value << " by row reduction isolation" << endl;
-        }
-      } else if (enable_logging) {
-        cout << "Deduced value for variable v" << variable_index
-             << " is not binary, it has value: " << deduced_value << " skipping"
-             << endl;
+    // Known values are substituted eagerly, so every variable left in the row
+    // is unknown and the bounds rule of deduce_variables applies directly
+    int positive_value;
+    if (row.target_sum == unknown_positive) {
+      positive_value = 1;
+    } else if (row.target_sum == -unknown_negative) {
+      positive_value = 0;
+    } else {
+      continue;
+    }
+
+    forced.clear();
+    for_each_variable(row, [&](int var, int coeff) {
+      forced.emplace_back(var, coeff > 0 ? positive_value : 1 - positive_value);
+    });
+    for (auto [var, value] : forced) {
+      if (values[var] == -1) {
+        assign(var, value);
+        deduced.emplace_back(var, value);
       }
     }
   }
 
-  // Return the map containing the deduced variable values.
-  return var_name_to_deduced_value;
+  return deduced;
 }
@@ -1,8 +1,10 @@
 #ifndef LINEAR_SYSTEM_SOLVER_HPP
 #define LINEAR_SYSTEM_SOLVER_HPP
 
+#include <cstdint>
 #include <vector>
 #include <set>
+#include <span>
 #include <unordered_map>
 
 /**
@@ -26,6 +28,57 @@ struct LinearEquation {
     bool operator<(const LinearEquation& other) const;
 };
 
+/**
+ * @brief A system of linear equations in compressed sparse row form.
+ *
+ * Variables are numbered with compact ids 0..num_variables() - 1, and
+ * variable_cells maps each id back to whatever the caller numbers them by (the
+ * solver uses board indices). Every stored coefficient is 1, so a row is just
+ * the list of its variables and a target sum.
+ */
+struct SparseSystem {
+    std::vector<int> variable_cells; ///< Caller side index of each compact variable id.
+    std::vector<int> row_offsets{0}; ///< Row i spans columns[row_offsets[i], row_offsets[i + 1]).
+    std::vector<int> columns;        ///< Compact variable ids of every row, back to back.
+    std::vector<int> target_sums;    ///< The target sum of each row.
+
+    int num_variables() const { return static_cast<int>(variable_cells.size()); }
+    int num_equations() const { return static_cast<int>(target_sums.size()); }
+
+    /**
+     * @brief Closes the row made of the columns pushed since the previous row.
+     *
+     * @param target_sum The target sum of the row.
+     */
+    void end_row(int target_sum) {
+        row_offsets.push_back(static_cast<int>(columns.size()));
+        target_sums.push_back(target_sum);
+    }
+
+    /**
+     * @brief Removes every row and variable, the buffers keep their capacity.
+     */
+    void clear() {
+        variable_cells.clear();
+        row_offsets.assign(1, 0);
+        columns.clear();
+        target_sums.clear();
+    }
+};
+
+/**
+ * @brief Splits a system into independent systems that share no variables.
+ *
+ * Two variables belong to the same component when some row contains both, so
+ * each component can be reduced and deduced on its own. The variable_cells of
+ * a component map its compact ids straight to the caller side indices of the
+ * input system, in the same relative order.
+ *
+ * @param system The system to split.
+ * @return One system per connected component of the variable graph.
+ */
+std::vector<SparseSystem> split_into_components(const SparseSystem& system);
+
 /**
  * @brief Creates an augmented matrix from a set of linear equations.
  * 
@@ -37,7 +90,20 @@ std::vector<std::vector<int>> create_augmented_matrix(
     const std::set<LinearEquation>& equations, int num_variables);
 
 /**
- * @brief Performs Gaussian elimination on the augmented matrix.
+ * @brief Creates an augmented matrix over the compact variables of a sparse system.
+ * 
+ * @param system The sparse system of equations.
+ * @return The augmented matrix, one column per compact variable plus the target.
+ */
+std::vector<std::vector<int>> create_augmented_matrix(const SparseSystem& system);
+
+/**
+ * @brief Performs fraction free Gauss-Jordan elimination on the augmented matrix.
+ *
+ * Rows are combined by cross multiplying with the pivot and then divided by
+ * the gcd of their entries, so every entry stays an exact integer and a pivot
+ * row keeps its leading coefficient instead of being scaled to 1. A row whose
+ * entries would overflow an int is left unreduced for that pivot.
  * 
  * @param augmented_matrix The augmented matrix to be reduced.
  * @param num_variables The number of binary variables.
@@ -47,6 +113,10 @@ void gaussian_elimination(std::vector<std::vector<int>>& augmented_matrix, int n
 
 /**
  * @brief Deduces the values of binary variables from the reduced augmented matrix.
+ *
+ * A row with known values substituted can only reach its target with some
+ * variables at one value, which works for any mix of positive and negative
+ * coefficients: in x - y + 2z = 2, z must be 1 and then x = y.
  * 
  * @param augmented_matrix The reduced augmented matrix.
  * @param num_variables The number of binary variables.
@@ -55,6 +125,155 @@ void gaussian_elimination(std::vector<std::vector<int>>& augmented_matrix, int n
  */
 std::unordered_map<int, int> deduce_variables(const std::vector<std::vector<int>>& augmented_matrix, int num_variables, bool enable_logging = false);
 
+/**
+ * @brief A row of the augmented matrix stored as packed 64-bit bit masks.
+ *
+ * Every coefficient is restricted to -1, 0 or 1, so a row is fully described
+ * by the set of variables with coefficient +1 and the set with coefficient -1.
+ * Only the words between first_word and first_word + positive.size() are
+ * stored, which keeps a row of a board equation (at most 8 neighbouring
+ * variables) a handful of words long no matter how large the board is.
+ */
+struct BitsetRow {
+    int first_word = 0; ///< Index of the first stored 64-bit word.
+    std::vector<std::uint64_t> positive; ///< Bit j set when v_j has coefficient +1.
+    std::vector<std::uint64_t> negative; ///< Bit j set when v_j has coefficient -1.
+    int target_sum = 0; ///< The right-hand side of the equation.
+};
+
+using BitsetMatrix = std::vector<BitsetRow>;
+
+/**
+ * @brief Creates a bit-packed augmented matrix from a set of linear equations.
+ * 
+ * @param equations The set of linear equations.
+ * @param num_variables The number of binary variables.
+ * @return The bit-packed matrix representing the system of equations.
+ */
+BitsetMatrix create_bitset_matrix(const std::set<LinearEquation>& equations, int num_variables);
+
+/**
+ * @brief Creates a bit-packed matrix over the compact variables of a sparse system.
+ * 
+ * @param system The sparse system of equations.
+ * @return The bit-packed matrix representing the system of equations.
+ */
+BitsetMatrix create_bitset_matrix(const SparseSystem& system);
+
+/**
+ * @brief Performs Gaussian elimination on a bit-packed matrix.
+ *
+ * Row operations are word-wide AND/OR/NOT kernels over the sign masks. A row
+ * operation which would produce a coefficient of +-2 cannot be represented, so
+ * that row is left unreduced for the current pivot; every row is still a valid
+ * linear combination of the input equations, so deductions stay sound.
+ * 
+ * @param matrix The bit-packed matrix to be reduced.
+ * @param num_variables The number of binary variables.
+ * @param enable_logging Boolean to enable or disable logging of the steps.
+ */
+void gaussian_elimination(BitsetMatrix& matrix, int num_variables, bool enable_logging = false);
+
+/**
+ * @brief Deduces the values of binary variables from a reduced bit-packed matrix.
+ *
+ * A row whose target equals the largest (or smallest) value its left-hand side
+ * can take forces every variable in it: +1 variables to 1 and -1 variables to 0
+ * (or the other way around).
+ * 
+ * @param matrix The reduced bit-packed matrix.
+ * @param num_variables The number of binary variables.
+ * @param enable_logging Boolean to enable or disable logging of the deduction steps.
+ * @return A map of variable indices to their deduced values.
+ */
+std::unordered_map<int, int> deduce_variables(const BitsetMatrix& matrix, int num_variables, bool enable_logging = false);
+
+/**
+ * @brief A bit-packed system of equations kept in reduced form between updates.
+ *
+ * Equations are added one at a time and reduced against the current pivots,
+ * and known variable values are substituted straight into every row that
+ * contains them. Only rows touched by an update are re-pivoted or re-checked
+ * by deduce(), so the work per round follows the number of changed cells
+ * rather than the size of the system.
+ *
+ * Every buffer, rows included, is kept across reset() and reused, so once a
+ * system has seen a board of its size a round allocates nothing.
+ */
+class IncrementalSystem {
+public:
+    /**
+     * @brief Clears the system, keeping its buffers for reuse.
+     *
+     * @param num_variables Variable ids range over [0, num_variables).
+     */
+    void reset(int num_variables);
+
+    /**
+     * @brief Adds an equation whose variables all have coefficient 1.
+     *
+     * @param variables The unknown variables of the equation.
+     * @param target_sum The target sum of the equation.
+     */
+    void add_equation(std::span<const int> variables, int target_sum);
+
+    /**
+     * @brief Fixes the value of a variable and substitutes it into every row.
+     *
+     * @param var The variable id.
+     * @param value The value of the variable, 0 or 1.
+     */
+    void assign(int var, int value);
+
+    /**
+     * @brief Deduces every value forced by the rows changed since the last call.
+     *
+     * Deduced values are assigned before returning, so they are not reported again.
+     *
+     * @return The (variable id, value) pairs deduced by this call, each variable
+     *         once. The list is owned by the system and overwritten by the next call.
+     */
+    const std::vector<std::pair<int, int>>& deduce();
+
+    /**
+     * @brief The value of a variable, -1 while it is unknown.
+     */
+    int value(int var) const { return values[var]; }
+
+    /**
+     * @brief Number of rows in use, reduced ones included.
+     */
+    int num_rows() const { return rows.size() - free_rows.size(); }
+
+    /**
+     * @brief Number of unknown variables some row has held, the columns a
+     * matrix of the system would have.
+     */
+    int num_columns() const { return live_variables; }
+
+private:
+    std::vector<BitsetRow> rows; ///< Every row ever used, free ones included.
+    std::vector<int> pivot_of_row;  ///< Pivot variable of each row, -1 if none.
+    std::vector<int> row_of_pivot;  ///< Row pivoting on each variable, -1 if none.
+    std::vector<signed char> values;
+    std::vector<std::vector<int>> rows_of_var; ///< Rows that may contain each variable.
+    std::vector<int> free_rows;
+    std::vector<int> dirty_rows;
+    std::vector<char> is_dirty;
+    std::vector<int> repivot_rows;
+    std::vector<int> scratch;
+    std::vector<std::pair<int, int>> forced;
+    std::vector<std::pair<int, int>> deduced;
+    std::vector<int> tried;   ///< Pivots reduce_row() already tried on its row.
+    std::vector<int> holders; ///< Rows a new pivot is eliminated from.
+    int live_variables = 0;   ///< Unknown variables whose rows_of_var is not empty.
+
+    void mark_dirty(int r);
+    void release_row(int r);
+    bool combine(int dst, int src, int sign);
+    void reduce_row(int r);
+};
+
 /**
  * @brief Prints the matrix to the console.
  * 
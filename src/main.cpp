@@ -1,9 +1,8 @@
 #include <cstdlib>
 #include <ctime>
 
-#include "game_logic.hpp"
+#include "tui.hpp"
 
 int main(int argc, char *argv[]) {
-  start_game(argc, argv);
-  return 0;
+  return start_game(argc, argv);
 }
@@ -0,0 +1,243 @@
+#include "no_guess_generator.hpp"
+#include "solver.hpp"
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstdlib>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+// Moves the mine at from to the empty cell to, keeping the counts of every
+// neighbour up to date
+static void move_mine(Board &board, int from, int to) {
+  auto add_to_neighbours = [&](int idx, int delta) {
+    for (int offset : board.neighbour_offsets()) {
+      int n_idx = idx + offset;
+      if (board.in_bounds(board.row_of(n_idx), board.col_of(n_idx))) {
+        board[n_idx].adjacent_mines += delta;
+      }
+    }
+  };
+
+  board.set_mine(from, false);
+  add_to_neighbours(from, -1);
+  board.set_mine(to, true);
+  add_to_neighbours(to, 1);
+
+  int count = 0;
+  for (int offset : board.neighbour_offsets()) {
+    count += board[from + offset].is_mine;
+  }
+  board[from].adjacent_mines = count;
+}
+
+// Picks a uniformly random element of a non-empty list
+static int pick(const std::vector<int> &cells, Rng &rng) {
+  return cells[rng.below(static_cast<std::uint32_t>(cells.size()))];
+}
+
+std::optional<NoGuessBoard> construct_no_guess_board(int mines_count,
+                                                     int height, int width,
+                                                     Rng &rng,
+                                                     int max_perturbations,
+                                                     std::stop_token stop) {
+  Board board(height, width);
+  if (board.empty()) {
+    return std::nullopt;
+  }
+
+  int start_row = static_cast<int>(rng.below(height));
+  int start_col = static_cast<int>(rng.below(width));
+
+  // The start and its neighbours never hold a mine, so the start always opens
+  std::vector<char> is_protected(board.padded_size(), 0);
+  std::vector<int> free_cells;
+  for (int row = 0; row < height; row++) {
+    for (int col = 0; col < width; col++) {
+      if (std::abs(row - start_row) <= 1 && std::abs(col - start_col) <= 1) {
+        is_protected[board.index(row, col)] = 1;
+      } else {
+        free_cells.push_back(board.index(row, col));
+      }
+    }
+  }
+  if (mines_count > static_cast<int>(free_cells.size())) {
+    return std::nullopt;
+  }
+
+  rng.shuffle_prefix(free_cells.begin(), free_cells.end(), mines_count);
+  for (int k = 0; k < mines_count; k++) {
+    board.set_mine(free_cells[k], true);
+  }
+  for (int row = 0; row < height; row++) {
+    for (int col = 0; col < width; col++) {
+      int idx = board.index(row, col);
+      int count = 0;
+      for (int offset : board.neighbour_offsets()) {
+        count += board[idx + offset].is_mine;
+      }
+      board[idx].adjacent_mines = count;
+    }
+  }
+
+  Solver solver(EliminationBackend::incremental, false, 1, rng());
+
+  // state carries the solver's progress, mines are moved on both boards
+  Board state = board;
+  reveal_cell(state, start_row, start_col);
+  bool solved = solver.solve_from_state(state, mines_count, stop);
+
+  std::vector<int> frontier_mines, frontier_safe, inner_mines, inner_safe;
+
+  for (int step = 0; step <= max_perturbations && !stop.stop_requested();
+       step++) {
+    if (solved) {
+      // Check from scratch, deductions made before a mine moved may not hold
+      state = board;
+      reveal_cell(state, start_row, start_col);
+      if (solver.solve_from_state(state, mines_count, stop)) {
+        return NoGuessBoard{std::move(board), {start_row, start_col}};
+      }
+    }
+
+    if (step == max_perturbations) {
+      break;
+    }
+
+    // Split the unknown cells into those next to a revealed cell and the rest
+    frontier_mines.clear();
+    frontier_safe.clear();
+    inner_mines.clear();
+    inner_safe.clear();
+    for (int row = 0; row < height; row++) {
+      for (int col = 0; col < width; col++) {
+        int idx = board.index(row, col);
+        if (state[idx].is_revealed || state[idx].is_flagged ||
+            is_protected[idx]) {
+          continue;
+        }
+        bool on_frontier = false;
+        for (int offset : board.neighbour_offsets()) {
+          int n_idx = idx + offset;
+          bool is_sentinel = !board.in_bounds(board.row_of(n_idx),
+                                              board.col_of(n_idx));
+          on_frontier = on_frontier ||
+                        (state[n_idx].is_revealed && !is_sentinel);
+        }
+        if (on_frontier) {
+          (board[idx].is_mine ? frontier_mines : frontier_safe).push_back(idx);
+        } else {
+          (board[idx].is_mine ? inner_mines : inner_safe).push_back(idx);
+        }
+      }
+    }
+
+    // Prefer clearing a frontier mine into the unknown interior, then moving
+    // it along the frontier, and only then pulling a mine onto the frontier
+    int from, to;
+    if (!frontier_mines.empty() && !inner_safe.empty()) {
+      from = pick(frontier_mines, rng);
+      to = pick(inner_safe, rng);
+    } else if (!frontier_mines.empty() && !frontier_safe.empty()) {
+      from = pick(frontier_mines, rng);
+      to = pick(frontier_safe, rng);
+    } else if (!inner_mines.empty() && !frontier_safe.empty()) {
+      from = pick(inner_mines, rng);
+      to = pick(frontier_safe, rng);
+    } else {
+      return std::nullopt;
+    }
+
+    move_mine(board, from, to);
+    move_mine(state, from, to);
+    solved = solver.solve_from_state(state, mines_count, stop);
+  }
+
+  return std::nullopt;
+}
+
+std::optional<NoGuessBoard>
+generate_no_guess_board(int mines_count, int height, int width, int jobs,
+                        GenerationMode mode, std::uint64_t seed,
+                        std::stop_token stop, const BoardFilter &accept) {
+  // Candidate k is drawn from its own stream of seed and the lowest solvable
+  // candidate wins, so the board does not depend on jobs or on timing
+  int num_workers = std::max(1, jobs);
+  std::atomic<long> next_candidate = 0;
+  std::atomic<long> best = LONG_MAX;
+  std::optional<NoGuessBoard> result;
+
+  std::mutex in_flight_mutex;
+  std::vector<long> in_flight(num_workers, LONG_MAX);
+  std::vector<std::stop_source> attempt_stops(num_workers);
+
+  auto worker = [&](int id) {
+    Solver solver(EliminationBackend::incremental, false);
+
+    while (not stop.stop_requested()) {
+      long k = next_candidate++;
+      if (k > best) {
+        return;
+      }
+      std::stop_source attempt_stop;
+      {
+        std::lock_guard lock(in_flight_mutex);
+        in_flight[id] = k;
+        attempt_stops[id] = attempt_stop;
+      }
+      std::stop_callback forward_stop(stop,
+                                      [&] { attempt_stop.request_stop(); });
+
+      Rng rng(Rng::stream_seed(seed, k));
+      std::optional<NoGuessBoard> candidate;
+      if (mode == GenerationMode::constructive) {
+        candidate = construct_no_guess_board(mines_count, height, width, rng,
+                                             1000, attempt_stop.get_token());
+        if (candidate.has_value() && accept &&
+            !accept(measure_board(candidate->board))) {
+          candidate.reset();
+        }
+      } else {
+        Board board = generate_board(mines_count, height, width, rng);
+        if (accept && !accept(measure_board(board))) {
+          continue;
+        }
+        solver.reseed(rng());
+        auto solution =
+            solver.solve(board, mines_count, attempt_stop.get_token());
+        if (solution.has_value()) {
+          candidate = NoGuessBoard{std::move(board), solution.value()};
+        }
+      }
+
+      if (candidate.has_value()) {
+        std::lock_guard lock(in_flight_mutex);
+        if (k < best) {
+          best = k;
+          result = std::move(candidate);
+          for (int other = 0; other < num_workers; ++other) {
+            if (in_flight[other] > k) {
+              attempt_stops[other].request_stop();
+            }
+          }
+        }
+      }
+    }
+  };
+
+  {
+    std::vector<std::jthread> workers;
+    for (int id = 0; id < num_workers; ++id) {
+      workers.emplace_back(worker, id);
+    }
+  } // the workers join here
+
+  if (result.has_value()) {
+    auto [row, col] = result->safe_start;
+    result->board.at(row, col).safe_start = true;
+  }
+  return result;
+}
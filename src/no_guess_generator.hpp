@@ -0,0 +1,81 @@
+#ifndef NO_GUESS_GENERATOR_HPP
+#define NO_GUESS_GENERATOR_HPP
+
+#include "board_analysis.hpp"
+#include "game_logic.hpp"
+#include <optional>
+#include <stop_token>
+#include <cstdint>
+#include <utility>
+
+/**
+ * @brief A no guess board together with the cell it is solvable from.
+ */
+struct NoGuessBoard {
+  Board board;                    ///< The board, its safe start cell is marked.
+  std::pair<int, int> safe_start; ///< The (row, col) to start the game from.
+};
+
+/**
+ * @brief How a no guess board is produced.
+ */
+enum class GenerationMode {
+  reroll,       ///< Generate random boards until one is no guess solvable.
+  constructive, ///< Repair one random board by moving mines where the solver got stuck.
+};
+
+/**
+ * @brief Builds a no guess board by repairing a single random board.
+ *
+ * A start cell is picked and its neighbourhood is kept free of mines so that it
+ * opens. Whenever the solver gets stuck a mine on the stuck frontier is moved
+ * to an unknown cell, keeping the mine count, and solving resumes from the
+ * stuck state. Once solved, the board is checked again from the start cell
+ * since earlier deductions may have relied on numbers that have since changed.
+ *
+ * @param mines_count Number of mines to place on the board.
+ * @param height Number of rows of the board.
+ * @param width Number of columns of the board.
+ * @param rng The random engine used to place and move the mines.
+ * @param max_perturbations Number of mine moves to try before giving up.
+ * @param stop Requesting a stop gives up early.
+ * @return The board and its safe start cell, std::nullopt if the budget ran
+ *         out or there is no room to move mines.
+ */
+std::optional<NoGuessBoard> construct_no_guess_board(int mines_count, int height,
+                                                     int width, Rng &rng,
+                                                     int max_perturbations = 1000,
+                                                     std::stop_token stop = {});
+
+/**
+ * @brief Generates a no guess board using several threads.
+ *
+ * The jobs threads share out numbered candidate boards, each produced by
+ * rerolling or constructing it depending on mode from its own stream of seed.
+ * The lowest numbered candidate that is no guess solvable is returned and the
+ * attempts on higher numbers are stopped, so equal seeds give equal boards for
+ * any number of jobs.
+ *
+ * With accept set, candidates it rejects are skipped. A rerolled candidate is
+ * measured before it is solved, so a rejected one costs a single pass, a
+ * constructed candidate can only be measured once it is built. If accept
+ * rejects every board the generation runs until it is stopped.
+ *
+ * @param mines_count Number of mines to place on the board.
+ * @param height Number of rows of the board.
+ * @param width Number of columns of the board.
+ * @param jobs Number of threads to generate boards on, at least one is used.
+ * @param mode How each thread produces its candidate boards.
+ * @param seed Seed of the whole generation.
+ * @param stop Requesting a stop abandons the generation.
+ * @param accept Filter on the metrics of the candidates, empty to accept all.
+ * @return The generated board and its safe start cell, std::nullopt only if
+ *         the generation was stopped.
+ */
+std::optional<NoGuessBoard>
+generate_no_guess_board(int mines_count, int height, int width, int jobs,
+                        GenerationMode mode = GenerationMode::reroll,
+                        std::uint64_t seed = 0, std::stop_token stop = {},
+                        const BoardFilter &accept = {});
+
+#endif // NO_GUESS_GENERATOR_HPP
@@ -0,0 +1,551 @@
+#include "probability.hpp"
+#include "linear_system_solver.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+// Weights of a component by the number of mines it holds, value[j] is the
+// weight of low + j mines
+struct Counts {
+  int low = 0;
+  std::vector<double> value;
+
+  int high() const { return low + static_cast<int>(value.size()); }
+};
+
+// dst += src shifted up by shift mines
+void add_shifted(Counts &dst, const Counts &src, int shift) {
+  if (src.value.empty()) {
+    return;
+  }
+  int src_low = src.low + shift;
+  if (dst.value.empty()) {
+    dst.low = src_low;
+    dst.value = src.value;
+    return;
+  }
+  if (src_low < dst.low) {
+    dst.value.insert(dst.value.begin(), dst.low - src_low, 0.0);
+    dst.low = src_low;
+  }
+  if (src_low + static_cast<int>(src.value.size()) > dst.high()) {
+    dst.value.resize(src_low + src.value.size() - dst.low, 0.0);
+  }
+  for (std::size_t j = 0; j < src.value.size(); ++j) {
+    dst.value[src_low - dst.low + j] += src.value[j];
+  }
+}
+
+Counts convolve(const Counts &a, const Counts &b) {
+  Counts result;
+  if (a.value.empty() || b.value.empty()) {
+    return result;
+  }
+  result.low = a.low + b.low;
+  result.value.assign(a.value.size() + b.value.size() - 1, 0.0);
+  for (std::size_t i = 0; i < a.value.size(); ++i) {
+    for (std::size_t j = 0; j < b.value.size(); ++j) {
+      result.value[i + j] += a.value[i] * b.value[j];
+    }
+  }
+  return result;
+}
+
+// How one equation is carried from layer i to layer i + 1
+struct Carry {
+  int equation;
+  int from;      // position in the layer i state, -1 if it starts at variable i
+  bool contains; // whether variable i is in the equation
+  int remaining; // variables of the equation after variable i
+  bool stays;    // whether it is still open at layer i + 1
+};
+
+// The states reached after deciding the first i variables of a component. A
+// state is the residual target of every equation started but not finished,
+// and placements reaching the same state have the same completions.
+struct Layer {
+  int width = 0;
+  std::vector<signed char> residuals;   // width values per state
+  std::vector<std::array<int, 2>> child; // next state for variable i = 0 / 1, -1 if none
+  std::vector<Counts> forward;          // placements of the prefix reaching each state
+};
+
+// Enumerated component, its variables are relabelled in search order
+struct Component {
+  std::vector<int> cells; // padded board index of each variable
+  std::vector<Layer> layers;
+  Counts total;
+};
+
+// Orders the variables breadth first from a variable in the fewest equations,
+// which walks along the frontier and keeps the open equations few
+std::vector<int> search_order(const SparseSystem &system) {
+  int num_variables = system.num_variables();
+  std::vector<std::vector<int>> rows_of_var(num_variables);
+  for (int row = 0; row < system.num_equations(); ++row) {
+    for (int k = system.row_offsets[row]; k < system.row_offsets[row + 1];
+         ++k) {
+      rows_of_var[system.columns[k]].push_back(row);
+    }
+  }
+
+  int start = 0;
+  for (int var = 1; var < num_variables; ++var) {
+    if (rows_of_var[var].size() < rows_of_var[start].size()) {
+      start = var;
+    }
+  }
+
+  std::vector<int> order{start};
+  std::vector<char> seen(num_variables, 0);
+  seen[start] = 1;
+  for (std::size_t head = 0; head < order.size(); ++head) {
+    for (int row : rows_of_var[order[head]]) {
+      for (int k = system.row_offsets[row]; k < system.row_offsets[row + 1];
+           ++k) {
+        int var = system.columns[k];
+        if (!seen[var]) {
+          seen[var] = 1;
+          order.push_back(var);
+        }
+      }
+    }
+  }
+  return order;
+}
+
+// Runs the memoized search over one component, false if it has no placement
+// or needs more than max_states states
+bool enumerate(const SparseSystem &system, int max_states,
+               Component &component) {
+  int n = system.num_variables();
+  int m = system.num_equations();
+
+  std::vector<int> order = search_order(system);
+  std::vector<int> rank(n);
+  for (int i = 0; i < n; ++i) {
+    rank[order[i]] = i;
+    component.cells.push_back(system.variable_cells[order[i]]);
+  }
+
+  std::vector<std::vector<int>> vars(m);
+  std::vector<std::vector<int>> starting_at(n);
+  for (int row = 0; row < m; ++row) {
+    for (int k = system.row_offsets[row]; k < system.row_offsets[row + 1];
+         ++k) {
+      vars[row].push_back(rank[system.columns[k]]);
+    }
+    std::sort(vars[row].begin(), vars[row].end());
+    starting_at[vars[row].front()].push_back(row);
+  }
+
+  component.layers.resize(n + 1);
+  component.layers[0].residuals.clear();
+  component.layers[0].forward.push_back(Counts{0, {1.0}});
+
+  std::vector<int> open; // equations open at the current layer, in state order
+  std::vector<Carry> carries;
+  std::vector<signed char> key;
+  std::unordered_map<std::string, int> state_of_key;
+  int num_states = 1;
+
+  for (int i = 0; i < n; ++i) {
+    Layer &layer = component.layers[i];
+    Layer &next = component.layers[i + 1];
+
+    carries.clear();
+    auto carry = [&](int row, int from) {
+      const std::vector<int> &row_vars = vars[row];
+      auto after = std::upper_bound(row_vars.begin(), row_vars.end(), i);
+      bool contains = std::binary_search(row_vars.begin(), row_vars.end(), i);
+      carries.push_back(Carry{row, from, contains,
+                              static_cast<int>(row_vars.end() - after),
+                              row_vars.back() > i});
+    };
+    for (int pos = 0; pos < static_cast<int>(open.size()); ++pos) {
+      carry(open[pos], pos);
+    }
+    for (int row : starting_at[i]) {
+      carry(row, -1);
+    }
+
+    open.clear();
+    for (const Carry &c : carries) {
+      if (c.stays) {
+        open.push_back(c.equation);
+      }
+    }
+    next.width = open.size();
+
+    int layer_states = layer.forward.size();
+    layer.child.assign(layer_states, {-1, -1});
+    state_of_key.clear();
+
+    for (int s = 0; s < layer_states; ++s) {
+      const signed char *residual = layer.residuals.data() + s * layer.width;
+      for (int x = 0; x < 2; ++x) {
+        key.clear();
+        bool consistent = true;
+        for (const Carry &c : carries) {
+          int r = c.from >= 0 ? residual[c.from] : system.target_sums[c.equation];
+          if (c.contains) {
+            r -= x;
+          }
+          if (r < 0 || r > c.remaining) {
+            consistent = false;
+            break;
+          }
+          if (c.stays) {
+            key.push_back(static_cast<signed char>(r));
+          }
+        }
+        if (!consistent) {
+          continue;
+        }
+
+        auto [it, inserted] = state_of_key.try_emplace(
+            std::string(key.begin(), key.end()), next.forward.size());
+        if (inserted) {
+          if (++num_states > max_states) {
+            return false;
+          }
+          next.residuals.insert(next.residuals.end(), key.begin(), key.end());
+          next.forward.emplace_back();
+        }
+        layer.child[s][x] = it->second;
+        add_shifted(next.forward[it->second], layer.forward[s], x);
+      }
+    }
+
+    if (next.forward.empty()) {
+      return false;
+    }
+  }
+
+  // every equation is closed after the last variable, so one state is left
+  component.total = component.layers[n].forward[0];
+  return true;
+}
+
+// Adds every variable's weighted share of the placements to numerators, where
+// weight[k] weighs the placements of the component holding k mines
+double weigh(const Component &component, const std::vector<double> &weight,
+             std::vector<double> &numerators) {
+  int n = component.cells.size();
+  auto weight_of = [&](int k) {
+    return k < static_cast<int>(weight.size()) ? weight[k] : 0.0;
+  };
+
+  // backward[s][j] weighs every completion of state s whose prefix holds
+  // forward[s].low + j mines
+  std::vector<std::vector<double>> backward(1);
+  const Counts &total = component.layers[n].forward[0];
+  double z = 0;
+  for (std::size_t j = 0; j < total.value.size(); ++j) {
+    backward[0].push_back(weight_of(total.low + j));
+    z += total.value[j] * backward[0][j];
+  }
+
+  numerators.assign(n, 0.0);
+  std::vector<std::vector<double>> current;
+  for (int i = n - 1; i >= 0; --i) {
+    const Layer &layer = component.layers[i];
+    const Layer &next = component.layers[i + 1];
+    current.assign(layer.forward.size(), {});
+    for (std::size_t s = 0; s < layer.forward.size(); ++s) {
+      const Counts &f = layer.forward[s];
+      current[s].assign(f.value.size(), 0.0);
+      for (int x = 0; x < 2; ++x) {
+        int c = layer.child[s][x];
+        if (c < 0) {
+          continue;
+        }
+        int offset = f.low + x - next.forward[c].low;
+        for (std::size_t j = 0; j < f.value.size(); ++j) {
+          double completions = backward[c][offset + j];
+          current[s][j] += completions;
+          if (x == 1) {
+            numerators[i] += f.value[j] * completions;
+          }
+        }
+      }
+    }
+    backward.swap(current);
+  }
+  return z;
+}
+
+// Marks in can_be[i] bit x when some placement whose mine count is feasible
+// sets variable i to x. Works on which counts are non-zero only, so it is
+// exact where the weights of weigh() may round.
+void find_forced(const Component &component, const std::vector<char> &feasible,
+                 std::vector<int> &can_be) {
+  int n = component.cells.size();
+  auto feasible_of = [&](int k) {
+    return k < static_cast<int>(feasible.size()) && feasible[k];
+  };
+
+  std::vector<std::vector<char>> backward(1);
+  const Counts &total = component.layers[n].forward[0];
+  for (std::size_t j = 0; j < total.value.size(); ++j) {
+    backward[0].push_back(feasible_of(total.low + j));
+  }
+
+  can_be.assign(n, 0);
+  std::vector<std::vector<char>> current;
+  for (int i = n - 1; i >= 0; --i) {
+    const Layer &layer = component.layers[i];
+    const Layer &next = component.layers[i + 1];
+    current.assign(layer.forward.size(), {});
+    for (std::size_t s = 0; s < layer.forward.size(); ++s) {
+      const Counts &f = layer.forward[s];
+      current[s].assign(f.value.size(), 0);
+      for (int x = 0; x < 2; ++x) {
+        int c = layer.child[s][x];
+        if (c < 0) {
+          continue;
+        }
+        int offset = f.low + x - next.forward[c].low;
+        for (std::size_t j = 0; j < f.value.size(); ++j) {
+          if (backward[c][offset + j]) {
+            current[s][j] = 1;
+            if (f.value[j] > 0) {
+              can_be[i] |= 1 << x;
+            }
+          }
+        }
+      }
+    }
+    backward.swap(current);
+  }
+}
+
+// Which mine counts have a placement, as 0 or 1
+Counts support(const Counts &counts) {
+  Counts result = counts;
+  for (double &value : result.value) {
+    value = value > 0 ? 1.0 : 0.0;
+  }
+  return result;
+}
+
+// log of n choose k
+double log_choose(int n, int k) {
+  return std::lgamma(n + 1.0) - std::lgamma(k + 1.0) - std::lgamma(n - k + 1.0);
+}
+
+} // namespace
+
+// Board and SolverState give the same Cell through operator[], the one of a
+// SolverState never has is_mine set
+template <class Layout>
+static std::optional<MineProbabilities>
+probabilities_of(const Layout &board, int mine_count, int max_states) {
+  MineProbabilities result;
+  result.of_cell.assign(board.padded_size(), 0.0);
+  result.forced.assign(board.padded_size(), 0);
+
+  SparseSystem system;
+  std::vector<int> variable_of_cell(board.padded_size(), -1);
+  int remaining_mines = mine_count;
+  int num_unknown = 0;
+
+  for (int r = 0; r < board.height(); ++r) {
+    for (int c = 0; c < board.width(); ++c) {
+      int idx = board.index(r, c);
+      const Cell &cell = board[idx];
+      if (cell.is_flagged || (cell.is_revealed && cell.is_mine)) {
+        result.of_cell[idx] = 1.0;
+        result.forced[idx] = 1;
+        remaining_mines -= 1;
+        continue;
+      }
+      if (!cell.is_revealed) {
+        num_unknown += 1;
+        continue;
+      }
+
+      int target_sum = cell.adjacent_mines;
+      int row_begin = system.columns.size();
+      for (int offset : board.neighbour_offsets()) {
+        int n_idx = idx + offset;
+        const Cell &neighbour = board[n_idx];
+        if (neighbour.is_flagged || (neighbour.is_revealed && neighbour.is_mine)) {
+          target_sum -= 1;
+        } else if (!neighbour.is_revealed) {
+          if (variable_of_cell[n_idx] == -1) {
+            variable_of_cell[n_idx] = system.num_variables();
+            system.variable_cells.push_back(n_idx);
+          }
+          system.columns.push_back(variable_of_cell[n_idx]);
+        }
+      }
+      if (static_cast<int>(system.columns.size()) == row_begin) {
+        if (target_sum != 0) {
+          return std::nullopt;
+        }
+        continue;
+      }
+      system.end_row(target_sum);
+    }
+  }
+
+  int num_interior = num_unknown - system.num_variables();
+  if (remaining_mines < 0 || remaining_mines > num_unknown) {
+    return std::nullopt;
+  }
+
+  std::vector<SparseSystem> systems = split_into_components(system);
+  std::vector<Component> components(systems.size());
+  for (std::size_t j = 0; j < systems.size(); ++j) {
+    if (!enumerate(systems[j], max_states, components[j])) {
+      return std::nullopt;
+    }
+    // only ratios matter, scaling keeps the products below in range
+    Counts &total = components[j].total;
+    double largest = *std::max_element(total.value.begin(), total.value.end());
+    for (double &value : total.value) {
+      value /= largest;
+    }
+  }
+
+  // The unknown cells behind the frontier hold whatever mines are left, in
+  // any of interior choose left ways
+  int num_frontier = system.num_variables();
+  std::vector<double> interior_weight(num_frontier + 1, 0.0);
+  double largest_log = -INFINITY;
+  for (int k = 0; k <= num_frontier; ++k) {
+    int left = remaining_mines - k;
+    if (left >= 0 && left <= num_interior) {
+      largest_log = std::max(largest_log, log_choose(num_interior, left));
+    }
+  }
+  for (int k = 0; k <= num_frontier; ++k) {
+    int left = remaining_mines - k;
+    if (left >= 0 && left <= num_interior) {
+      interior_weight[k] =
+          std::exp(log_choose(num_interior, left) - largest_log);
+    }
+  }
+
+  // prefix[j] and suffix[j] combine the components before and from j, and
+  // the support versions track which mine counts are possible at all
+  std::size_t num_components = components.size();
+  std::vector<Counts> prefix(num_components + 1), suffix(num_components + 1);
+  std::vector<Counts> prefix_support(num_components + 1),
+      suffix_support(num_components + 1);
+  prefix[0] = prefix_support[0] = {0, {1.0}};
+  suffix[num_components] = suffix_support[num_components] = {0, {1.0}};
+  for (std::size_t j = 0; j < num_components; ++j) {
+    prefix[j + 1] = convolve(prefix[j], components[j].total);
+    prefix_support[j + 1] = support(
+        convolve(prefix_support[j], support(components[j].total)));
+  }
+  for (std::size_t j = num_components; j-- > 0;) {
+    suffix[j] = convolve(components[j].total, suffix[j + 1]);
+    suffix_support[j] = support(
+        convolve(support(components[j].total), suffix_support[j + 1]));
+  }
+  auto interior_fits = [&](int k) {
+    int left = remaining_mines - k;
+    return left >= 0 && left <= num_interior;
+  };
+
+  const Counts &all = prefix[num_components];
+  double z = 0;
+  double interior_mines = 0;
+  for (std::size_t j = 0; j < all.value.size(); ++j) {
+    int k = all.low + j;
+    z += all.value[j] * interior_weight[k];
+    interior_mines += all.value[j] * interior_weight[k] * (remaining_mines - k);
+  }
+  if (!(z > 0)) {
+    return std::nullopt;
+  }
+
+  // every component is weighed by the placements of all the others
+  std::vector<double> weight, numerators;
+  std::vector<char> feasible;
+  std::vector<int> can_be;
+  for (std::size_t j = 0; j < num_components; ++j) {
+    Counts others = convolve(prefix[j], suffix[j + 1]);
+    Counts others_support =
+        support(convolve(prefix_support[j], suffix_support[j + 1]));
+    weight.assign(components[j].cells.size() + 1, 0.0);
+    feasible.assign(weight.size(), 0);
+    for (std::size_t k = 0; k < weight.size(); ++k) {
+      for (std::size_t r = 0; r < others.value.size(); ++r) {
+        std::size_t total_k = k + others.low + r;
+        if (total_k < interior_weight.size()) {
+          weight[k] += others.value[r] * interior_weight[total_k];
+        }
+        if (others_support.value[r] > 0 && interior_fits(total_k)) {
+          feasible[k] = 1;
+        }
+      }
+    }
+
+    double component_z = weigh(components[j], weight, numerators);
+    find_forced(components[j], feasible, can_be);
+    for (std::size_t i = 0; i < numerators.size(); ++i) {
+      int idx = components[j].cells[i];
+      result.of_cell[idx] = numerators[i] / component_z;
+      result.forced[idx] = can_be[i] == 1 ? 0 : can_be[i] == 2 ? 1 : -1;
+    }
+  }
+
+  // the interior is forced when every possible count leaves it empty or full
+  bool interior_can_be_safe = false;
+  bool interior_can_be_mine = false;
+  const Counts &all_support = prefix_support[num_components];
+  for (std::size_t j = 0; j < all_support.value.size(); ++j) {
+    int k = all_support.low + j;
+    if (all_support.value[j] > 0 && interior_fits(k)) {
+      interior_can_be_mine |= remaining_mines - k > 0;
+      interior_can_be_safe |= remaining_mines - k < num_interior;
+    }
+  }
+  signed char interior_forced = interior_can_be_safe == interior_can_be_mine
+                                    ? -1
+                                    : (interior_can_be_mine ? 1 : 0);
+
+  double interior_probability =
+      num_interior > 0 ? interior_mines / z / num_interior : 0.0;
+
+  for (int r = 0; r < board.height(); ++r) {
+    for (int c = 0; c < board.width(); ++c) {
+      int idx = board.index(r, c);
+      const Cell &cell = board[idx];
+      if (cell.is_revealed || cell.is_flagged) {
+        continue;
+      }
+      if (variable_of_cell[idx] == -1) {
+        result.of_cell[idx] = interior_probability;
+        result.forced[idx] = interior_forced;
+      }
+      if (result.safest_cell == -1 ||
+          result.of_cell[idx] < result.of_cell[result.safest_cell]) {
+        result.safest_cell = idx;
+      }
+    }
+  }
+
+  return result;
+}
+
+std::optional<MineProbabilities> mine_probabilities(const Board &board,
+                                                    int mine_count,
+                                                    int max_states) {
+  return probabilities_of(board, mine_count, max_states);
+}
+
+std::optional<MineProbabilities> mine_probabilities(const SolverState &state,
+                                                    int mine_count,
+                                                    int max_states) {
+  return probabilities_of(state, mine_count, max_states);
+}
@@ -0,0 +1,51 @@
+#ifndef PROBABILITY_HPP
+#define PROBABILITY_HPP
+
+#include "game_logic.hpp"
+#include "solver_state.hpp"
+#include <optional>
+#include <vector>
+
+/**
+ * @brief The exact mine probability of every cell of a board.
+ */
+struct MineProbabilities {
+  std::vector<double> of_cell; ///< Probability of each padded board index, 0 when
+                               ///< revealed and 1 when flagged.
+  int safest_cell = -1;        ///< Padded index of an unknown cell with the lowest
+                               ///< probability, -1 if there is none.
+  std::vector<signed char> forced; ///< For each padded board index, 0 or 1 when
+                                   ///< every placement agrees on the cell, -1
+                                   ///< otherwise. Decided without rounding.
+};
+
+/**
+ * @brief Computes the probability that each unknown cell holds a mine.
+ *
+ * Every placement of the remaining mines that agrees with the revealed numbers
+ * is taken to be equally likely, flagged cells count as mines. The unknown
+ * cells next to a revealed number are split into independent components and
+ * each is enumerated with a backtracking search which memoizes the residual
+ * targets of the equations it has started but not finished, so a component
+ * costs about its length times the number of distinct residual states. The
+ * components and the unknown cells behind the frontier are then combined
+ * through the global mine count.
+ *
+ * @param board The board, only what a player can see of it is used.
+ * @param mine_count Total number of mines of the board.
+ * @param max_states Most memoized states a single component may need.
+ * @return The probabilities, std::nullopt if no placement agrees with the
+ *         board or a component needs more than max_states states.
+ */
+std::optional<MineProbabilities> mine_probabilities(const Board &board,
+                                                    int mine_count,
+                                                    int max_states = 1 << 18);
+
+/**
+ * @brief The same on what a solver knows of a board.
+ */
+std::optional<MineProbabilities> mine_probabilities(const SolverState &state,
+                                                    int mine_count,
+                                                    int max_states = 1 << 18);
+
+#endif // PROBABILITY_HPP
@@ -0,0 +1,115 @@
+#ifndef RNG_HPP
+#define RNG_HPP
+
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <utility>
+
+/**
+ * @brief A small, fast random engine (xoshiro256**) with a reproducible stream.
+ *
+ * Unlike the standard distributions, below() and shuffle() are specified here,
+ * so equal seeds give equal results with every standard library. An engine is
+ * not thread safe, each thread should own one.
+ */
+class Rng {
+public:
+  using result_type = std::uint64_t;
+
+  /**
+   * @brief Seeds the engine, every seed including 0 gives a usable state.
+   */
+  explicit Rng(std::uint64_t seed = 0) { reseed(seed); }
+
+  void reseed(std::uint64_t seed) {
+    // splitmix64 spreads the seed over the whole state
+    for (std::uint64_t &word : state) {
+      word = mix(seed += 0x9e3779b97f4a7c15);
+    }
+  }
+
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() {
+    return std::numeric_limits<result_type>::max();
+  }
+
+  result_type operator()() {
+    result_type result = rotl(state[1] * 5, 7) * 9;
+    result_type t = state[1] << 17;
+    state[2] ^= state[0];
+    state[3] ^= state[1];
+    state[1] ^= state[2];
+    state[0] ^= state[3];
+    state[2] ^= t;
+    state[3] = rotl(state[3], 45);
+    return result;
+  }
+
+  /**
+   * @brief A uniformly random integer in [0, bound), without modulo bias.
+   *
+   * @param bound Must be positive.
+   */
+  std::uint32_t below(std::uint32_t bound) {
+    // Lemire's multiply and reject, the rejection is rare for small bounds
+    std::uint64_t product = (operator()() >> 32) * bound;
+    auto low = static_cast<std::uint32_t>(product);
+    if (low < bound) {
+      std::uint32_t threshold = -bound % bound;
+      while (low < threshold) {
+        product = (operator()() >> 32) * bound;
+        low = static_cast<std::uint32_t>(product);
+      }
+    }
+    return static_cast<std::uint32_t>(product >> 32);
+  }
+
+  /**
+   * @brief Fisher-Yates shuffles the first count elements into a random
+   * sample of the whole range, the rest is left in an unspecified order.
+   */
+  template <class It> void shuffle_prefix(It first, It last, std::size_t count) {
+    auto size = static_cast<std::size_t>(last - first);
+    for (std::size_t i = 0; i < count && i + 1 < size; i++) {
+      std::size_t j = i + below(static_cast<std::uint32_t>(size - i));
+      using std::swap;
+      swap(first[i], first[j]);
+    }
+  }
+
+  template <class It> void shuffle(It first, It last) {
+    shuffle_prefix(first, last, static_cast<std::size_t>(last - first));
+  }
+
+  /**
+   * @brief Derives the seed of an independent stream, so that work item
+   * stream of a run seeded with seed is the same whichever thread runs it.
+   */
+  static std::uint64_t stream_seed(std::uint64_t seed, std::uint64_t stream) {
+    return mix(seed ^ mix(stream + 0x9e3779b97f4a7c15));
+  }
+
+  /**
+   * @brief A fresh seed for runs that were not given one.
+   */
+  static std::uint64_t random_seed() {
+    std::random_device device;
+    return (static_cast<std::uint64_t>(device()) << 32) ^ device();
+  }
+
+private:
+  std::uint64_t state[4];
+
+  static std::uint64_t rotl(std::uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+  }
+
+  static std::uint64_t mix(std::uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    return z ^ (z >> 31);
+  }
+};
+
+#endif // RNG_HPP
@@ -1,203 +1,1119 @@
 #include "solver.hpp"
+#include "allocation_counter.hpp"
+#include "probability.hpp"
+#include "board_shape.hpp"
 #include <algorithm>
+#include <atomic>
+#include <bit>
+#include <climits>
 #include <iostream>
+#include <mutex>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
 
+DeductionStats &DeductionStats::operator+=(const DeductionStats &other) {
+  local += other.local;
+  elimination += other.elimination;
+  mine_count += other.mine_count;
+  enumeration += other.enumeration;
+  return *this;
+}
+
+SolveProfile &SolveProfile::operator+=(const SolveProfile &other) {
+  starts_tried += other.starts_tried;
+  rounds += other.rounds;
+  equations += other.equations;
+  max_rows = std::max(max_rows, other.max_rows);
+  max_columns = std::max(max_columns, other.max_columns);
+  generate_equations_seconds += other.generate_equations_seconds;
+  build_matrix_seconds += other.build_matrix_seconds;
+  elimination_seconds += other.elimination_seconds;
+  deduce_variables_seconds += other.deduce_variables_seconds;
+  local_seconds += other.local_seconds;
+  stuck_seconds += other.stuck_seconds;
+  total_seconds += other.total_seconds;
+  allocations += other.allocations;
+  return *this;
+}
+
+std::string SolveProfile::to_json() const {
+  std::ostringstream out;
+  out << "{\"starts_tried\": " << starts_tried << ", \"rounds\": " << rounds
+      << ", \"equations\": " << equations << ", \"max_rows\": " << max_rows
+      << ", \"max_columns\": " << max_columns
+      << ", \"generate_equations_seconds\": " << generate_equations_seconds
+      << ", \"build_matrix_seconds\": " << build_matrix_seconds
+      << ", \"elimination_seconds\": " << elimination_seconds
+      << ", \"deduce_variables_seconds\": " << deduce_variables_seconds
+      << ", \"local_seconds\": " << local_seconds
+      << ", \"stuck_seconds\": " << stuck_seconds
+      << ", \"total_seconds\": " << total_seconds;
+  if (allocation_counting_available()) {
+    out << ", \"allocations\": " << allocations;
+  }
+  out << "}";
+  return out.str();
+}
+
+// Adds the time until it is destroyed to *seconds, does nothing when seconds
+// is null so a solve that is not profiled never reads the clock
+class PhaseTimer {
+public:
+  explicit PhaseTimer(double *seconds) : seconds(seconds) {
+    if (seconds) {
+      start = std::chrono::steady_clock::now();
+    }
+  }
+  ~PhaseTimer() {
+    if (seconds) {
+      *seconds += std::chrono::duration<double>(
+                      std::chrono::steady_clock::now() - start)
+                      .count();
+    }
+  }
+  PhaseTimer(const PhaseTimer &) = delete;
+  PhaseTimer &operator=(const PhaseTimer &) = delete;
+
+private:
+  double *seconds;
+  std::chrono::steady_clock::time_point start;
+};
 
-std::set<LinearEquation>
-Solver::generate_linear_equations(std::vector<std::vector<Cell>> &board,
-                                  int mine_count) {
-  std::set<LinearEquation> equations;
-  // TODO generate the minecount contstraint as well
+Solver::Solver(EliminationBackend backend, bool enable_logging, int jobs,
+               std::uint64_t seed)
+    : backend(backend), enable_logging(enable_logging),
+      jobs(std::max(1, jobs)), rng(seed) {}
+
+std::unordered_map<int, int> Solver::deduce(const SparseSystem &system) {
+  if (system.num_equations() == 0) {
+    return {};
+  }
 
-  // Iterate over all cells to create linear equations
-  for (int r = 0; r < board.size(); ++r) {
-    for (int c = 0; c < board[r].size(); ++c) {
-      auto cell = board[r][c];
+  int num_variables = system.num_variables();
+  record_system_size(system.num_equations(), num_variables);
+
+  auto reduce = [&](auto &matrix) {
+    {
+      PhaseTimer timer(phase_seconds(&SolveProfile::elimination_seconds));
+      gaussian_elimination(matrix, num_variables);
+    }
+    PhaseTimer timer(phase_seconds(&SolveProfile::deduce_variables_seconds));
+    return deduce_variables(matrix, num_variables);
+  };
+
+  if (backend == EliminationBackend::bitset) {
+    BitsetMatrix matrix;
+    {
+      PhaseTimer timer(phase_seconds(&SolveProfile::build_matrix_seconds));
+      matrix = create_bitset_matrix(system);
+    }
+    return reduce(matrix);
+  }
+
+  std::vector<std::vector<int>> augmented_matrix;
+  {
+    PhaseTimer timer(phase_seconds(&SolveProfile::build_matrix_seconds));
+    augmented_matrix = create_augmented_matrix(system);
+  }
+
+  /* print_matrix(augmented_matrix); */
+
+  return reduce(augmented_matrix);
+}
+
+// Appends one row per revealed cell that borders an unknown one, numbering
+// the variables in the order they are met
+template <class Shape>
+static void gather_equations(const SolverState &board, Shape shape,
+                             std::vector<int> &variable_of_cell,
+                             SparseSystem &system) {
+  for (int r = 0; r < shape.height; ++r) {
+    int idx = shape.index(r, 0);
+    for (int c = 0; c < shape.width; ++c, ++idx) {
       /* right now we even generate eqn's on zeros as sometimes they can help:
        * 1100
        * 211#
        * F11#
        */
-      if (cell.is_revealed && !cell.is_flagged) {
-        LinearEquation eq;
-        eq.target_sum = board[r][c].adjacent_mines;
-
-        // Gather variables (indices of adjacent cells)
-        for (int dr = -1; dr <= 1; ++dr) {
-          for (int dc = -1; dc <= 1; ++dc) {
-            int nr = r + dr;
-            int nc = c + dc;
-            if (nr >= 0 && nr < board.size() && nc >= 0 &&
-                nc < board[r].size() && (dr != 0 || dc != 0)) {
-              if (board[nr][nc].is_flagged) {
-                eq.target_sum -= 1;
-              } else if (!board[nr][nc].is_revealed) {
-                eq.variables.push_back(nr * board[0].size() + nc);
-              }
-            }
-          }
+      if (!board.is_revealed(idx)) {
+        continue;
+      }
+
+      auto [flagged, unknown] = board.neighbour_masks(idx);
+      int target_sum = board.number(idx) - std::popcount(flagged);
+      std::size_t row_begin = system.columns.size();
+
+      // Gather variables (compact ids of adjacent cells), the sentinel border
+      // is revealed so it never contributes a variable
+      for (; unknown != 0; unknown &= unknown - 1) {
+        int n_idx = idx + shape.offsets[std::countr_zero(unknown)];
+        if (variable_of_cell[n_idx] == -1) {
+          variable_of_cell[n_idx] = system.num_variables();
+          system.variable_cells.push_back(n_idx);
         }
+        system.columns.push_back(variable_of_cell[n_idx]);
+      }
 
-        eq.normalize();
-        equations.insert(eq);
+      // cells away from the frontier say nothing about any unknown
+      if (system.columns.size() == row_begin) {
+        continue;
       }
+      system.end_row(target_sum);
     }
   }
+}
 
-  return equations;
+SparseSystem
+Solver::generate_linear_equations(const Board &board,
+                                  [[maybe_unused]] int mine_count) {
+  state.assign(board);
+  state.copy_known(board);
+  SparseSystem system;
+  generate_linear_equations(state, system);
+  return system;
 }
 
-void Solver::update_board(std::vector<std::vector<Cell>> &board,
+void Solver::generate_linear_equations(const SolverState &board,
+                                       SparseSystem &system) {
+  system.clear();
+  // the mine count constraint is kept out of the system, see
+  // deduce_from_mine_count
+
+  variable_of_cell.assign(board.padded_size(), -1);
+  dispatch_shape(board, [&](auto shape) {
+    gather_equations(board, shape, variable_of_cell, system);
+  });
+
+  // Renumber the variables in board order, so columns keep the same relative
+  // order they had when every cell was a column
+  std::vector<int> &order = variable_order;
+  order.assign(system.variable_cells.begin(), system.variable_cells.end());
+  std::sort(order.begin(), order.end());
+  for (int var = 0; var < static_cast<int>(order.size()); ++var) {
+    variable_of_cell[order[var]] = var;
+  }
+  for (int &column : system.columns) {
+    column = variable_of_cell[system.variable_cells[column]];
+  }
+  // the old variable list becomes the scratch buffer of the next call
+  system.variable_cells.swap(order);
+}
+
+void Solver::update_board(SolverState &board, const SparseSystem &system,
                           const std::unordered_map<int, int> &deduced_vars) {
   for (const auto &[var, value] : deduced_vars) {
 
-    int row = var / board[0].size();
-    int col = var % board[0].size();
+    int idx = system.variable_cells[var];
+
+    if (value == 1) {
+      board.set_flagged(idx, true);
+    } else if (value == 0) {
+      board.reveal(idx);
+    }
+  }
+}
 
+void Solver::update_board(
+    SolverState &board, const std::vector<std::pair<int, int>> &deduced_cells) {
+  for (const auto &[idx, value] : deduced_cells) {
     if (value == 1) {
-      board[row][col].is_flagged = true;
+      board.set_flagged(idx, true);
     } else if (value == 0) {
-      board[row][col].is_revealed = true;
+      board.reveal(idx);
     }
   }
 }
 
-bool Solver::is_board_solved(std::vector<std::vector<Cell>> &board) {
-  // Check if all cells are revealed or flagged correctly
-  for (const auto &row : board) {
-    for (const auto &cell : row) {
-      if ((cell.is_mine && !cell.is_flagged) ||
-          (!cell.is_mine && !cell.is_revealed)) {
-        return false;
+// Gathers the unknown neighbours of a revealed cell and returns how many mines
+// they hold
+static int unknown_neighbours(const SolverState &board, int idx,
+                              std::array<int, 8> &variables,
+                              int &num_variables) {
+  auto [flagged, unknown] = board.neighbour_masks(idx);
+  const std::array<int, 8> &offsets = board.neighbour_offsets();
+  num_variables = 0;
+  for (; unknown != 0; unknown &= unknown - 1) {
+    variables[num_variables++] = idx + offsets[std::countr_zero(unknown)];
+  }
+  return board.number(idx) - std::popcount(flagged);
+}
+
+void Solver::add_cell_equation(const SolverState &board, int idx) {
+  int num_variables = 0;
+  int target_sum =
+      unknown_neighbours(board, idx, equation_variables, num_variables);
+  incremental_system.add_equation(
+      std::span(equation_variables.data(), num_variables), target_sum);
+}
+
+// Encodes everything deduce() looks at, two components with the same key
+// always deduce the same values
+static std::vector<int> component_key(const SparseSystem &component) {
+  std::vector<int> key = component.variable_cells;
+  key.push_back(-1);
+  key.insert(key.end(), component.row_offsets.begin(),
+             component.row_offsets.end());
+  key.insert(key.end(), component.columns.begin(), component.columns.end());
+  key.insert(key.end(), component.target_sums.begin(),
+             component.target_sums.end());
+  return key;
+}
+
+void Solver::deduce_until_stuck(SolverState &board, int mine_count,
+                                std::stop_token stop) {
+  stuck_components.clear();
+  changed_cells = revealed_cells;
+
+  while (not stop.stop_requested()) {
+    last_profile.rounds++;
+    {
+      PhaseTimer timer(phase_seconds(&SolveProfile::local_seconds));
+      deduce_locally(board, changed_cells, local_deduced);
+    }
+    stats.local += local_deduced.size();
+    record_tiers(local_deduced, DeductionTier::local);
+    changed_cells.clear();
+
+    // Elimination only sees what the local rules could not resolve
+    SparseSystem &system = frontier_system;
+    {
+      PhaseTimer timer(phase_seconds(&SolveProfile::generate_equations_seconds));
+      generate_linear_equations(board, system);
+    }
+    last_profile.equations += system.num_equations();
+    for (const auto &component : split_into_components(system)) {
+      auto key = component_key(component);
+      if (stuck_components.contains(key)) {
+        continue;
+      }
+
+      auto deduced_vars = deduce(component);
+      if (deduced_vars.empty()) {
+        stuck_components.insert(std::move(key));
+      } else {
+        update_board(board, component, deduced_vars);
+        stats.elimination += deduced_vars.size();
+        for (const auto &[var, value] : deduced_vars) {
+          changed_cells.push_back(component.variable_cells[var]);
+          if (tracing) {
+            last_trace.cell_tiers[component.variable_cells[var]] =
+                DeductionTier::elimination;
+          }
+        }
       }
     }
+
+    if (changed_cells.empty()) {
+      {
+        PhaseTimer timer(phase_seconds(&SolveProfile::stuck_seconds));
+        deduce_when_stuck(board, mine_count, stuck_deduced);
+      }
+      update_board(board, stuck_deduced);
+      for (const auto &[idx, value] : stuck_deduced) {
+        changed_cells.push_back(idx);
+      }
+    }
+
+    if (changed_cells.empty()) {
+      if (enable_logging) {
+        std::cerr << "No variables could be deduced. Trying a new cell..."
+                  << std::endl;
+      }
+      return;
+    }
+
+    if (enable_logging) {
+      std::cout << "just updated board with information" << std::endl;
+      print_board(board);
+    }
   }
-  return true;
 }
 
-std::optional<std::pair<int, int>>
-Solver::solve(std::vector<std::vector<Cell>> &board, int mine_count) {
+void Solver::deduce_incrementally(SolverState &board, int mine_count,
+                                  std::stop_token stop) {
+  incremental_system.reset(board.padded_size());
+  changed_cells = revealed_cells;
+
+  while (not stop.stop_requested()) {
+    last_profile.rounds++;
+    {
+      PhaseTimer timer(phase_seconds(&SolveProfile::local_seconds));
+      deduce_locally(board, changed_cells, local_deduced);
+    }
+    stats.local += local_deduced.size();
+    record_tiers(local_deduced, DeductionTier::local);
+    for (auto [idx, value] : local_deduced) {
+      incremental_system.assign(idx, value);
+      if (value == 0) {
+        revealed_cells.push_back(idx);
+      }
+    }
+
+    {
+      PhaseTimer timer(phase_seconds(&SolveProfile::generate_equations_seconds));
+      for (int idx : revealed_cells) {
+        add_cell_equation(board, idx);
+      }
+    }
+    last_profile.equations += revealed_cells.size();
+    record_system_size(incremental_system.num_rows(),
+                       incremental_system.num_columns());
+
+    const std::vector<std::pair<int, int>> *deduced_cells;
+    {
+      PhaseTimer timer(phase_seconds(&SolveProfile::elimination_seconds));
+      deduced_cells = &incremental_system.deduce();
+    }
+    stats.elimination += deduced_cells->size();
+    record_tiers(*deduced_cells, DeductionTier::elimination);
+
+    if (deduced_cells->empty()) {
+      {
+        PhaseTimer timer(phase_seconds(&SolveProfile::stuck_seconds));
+        deduce_when_stuck(board, mine_count, stuck_deduced);
+      }
+      for (auto [idx, value] : stuck_deduced) {
+        incremental_system.assign(idx, value);
+      }
+      deduced_cells = &stuck_deduced;
+    }
+
+    if (deduced_cells->empty()) {
+      if (enable_logging) {
+        std::cerr << "No variables could be deduced. Trying a new cell..."
+                  << std::endl;
+      }
+      return;
+    }
+
+    update_board(board, *deduced_cells);
+    if (enable_logging) {
+      std::cout << "just updated board with information" << std::endl;
+      print_board(board);
+    }
+
+    revealed_cells.clear();
+    changed_cells.clear();
+    for (const auto &[idx, value] : *deduced_cells) {
+      changed_cells.push_back(idx);
+      if (value == 0) {
+        revealed_cells.push_back(idx);
+      }
+    }
+  }
+}
+
+void Solver::deduce_locally(SolverState &board, const std::vector<int> &changed,
+                            std::vector<std::pair<int, int>> &deduced) {
+  deduced.clear();
+  if (static_cast<int>(in_local_worklist.size()) != board.padded_size()) {
+    in_local_worklist.assign(board.padded_size(), 0);
+  }
+
+  auto queue_equation = [&](int idx) {
+    if (board.is_revealed(idx) && !in_local_worklist[idx] &&
+        board.in_bounds(board.row_of(idx), board.col_of(idx))) {
+      in_local_worklist[idx] = 1;
+      local_worklist.push_back(idx);
+    }
+  };
+  auto queue_around = [&](int idx) {
+    queue_equation(idx);
+    for (int offset : board.neighbour_offsets()) {
+      queue_equation(idx + offset);
+    }
+  };
+  auto resolve = [&](int idx, int value) {
+    // a cell two overlapping equations both resolve is only reported once
+    if (board.is_revealed(idx) || board.is_flagged(idx)) {
+      return;
+    }
+    if (value == 1) {
+      board.set_flagged(idx, true);
+    } else {
+      board.reveal(idx);
+    }
+    deduced.emplace_back(idx, value);
+    queue_around(idx);
+  };
+
+  for (int idx : changed) {
+    queue_around(idx);
+  }
+
+  std::array<int, 8> vars_a, vars_b, rest;
+  while (!local_worklist.empty()) {
+    int a = local_worklist.back();
+    local_worklist.pop_back();
+    in_local_worklist[a] = 0;
+
+    int num_a = 0;
+    int target_a = unknown_neighbours(board, a, vars_a, num_a);
+    if (num_a == 0) {
+      continue;
+    }
+    if (target_a == 0 || target_a == num_a) {
+      for (int k = 0; k < num_a; ++k) {
+        resolve(vars_a[k], target_a == 0 ? 0 : 1);
+      }
+      continue;
+    }
+
+    // Only revealed cells within two steps can share an unknown with a. Once
+    // a's unknowns change, vars_a is stale and a has been queued again
+    int row = board.row_of(a);
+    int col = board.col_of(a);
+    bool a_changed = false;
+    for (int dr = -2; dr <= 2 && !a_changed; ++dr) {
+      for (int dc = -2; dc <= 2; ++dc) {
+        if ((dr == 0 && dc == 0) || !board.in_bounds(row + dr, col + dc)) {
+          continue;
+        }
+        int b = board.index(row + dr, col + dc);
+        if (!board.is_revealed(b)) {
+          continue;
+        }
+        int num_b = 0;
+        int target_b = unknown_neighbours(board, b, vars_b, num_b);
+        if (num_b == 0) {
+          continue;
+        }
+
+        // rest = larger minus smaller when the smaller is a subset of it
+        auto subtract = [&](const std::array<int, 8> &big, int num_big,
+                            const std::array<int, 8> &small, int num_small) {
+          int num_rest = 0;
+          for (int i = 0; i < num_big; ++i) {
+            if (std::find(small.begin(), small.begin() + num_small, big[i]) ==
+                small.begin() + num_small) {
+              rest[num_rest++] = big[i];
+            }
+          }
+          return num_big - num_rest == num_small ? num_rest : 0;
+        };
 
-  int board_height = board.size();
-  int board_width = board[0].size();
+        if (int num_rest = subtract(vars_b, num_b, vars_a, num_a)) {
+          int target_rest = target_b - target_a;
+          if (target_rest == 0 || target_rest == num_rest) {
+            for (int k = 0; k < num_rest; ++k) {
+              resolve(rest[k], target_rest == 0 ? 0 : 1);
+            }
+          }
+        } else if (int num_rest = subtract(vars_a, num_a, vars_b, num_b)) {
+          int target_rest = target_a - target_b;
+          if (target_rest == 0 || target_rest == num_rest) {
+            for (int k = 0; k < num_rest; ++k) {
+              resolve(rest[k], target_rest == 0 ? 0 : 1);
+            }
+            a_changed = true;
+          }
+        }
+        if (a_changed) {
+          break;
+        }
+      }
+    }
+  }
 
-  int total_cells = board_width * board_height;
+  if (enable_logging && !deduced.empty()) {
+    std::cout << "local rules resolved " << deduced.size() << " cells"
+              << std::endl;
+  }
+}
+
+void Solver::deduce_when_stuck(SolverState &board, int mine_count,
+                               std::vector<std::pair<int, int>> &deduced) {
+  // Every attempt that solves its board ends here, with nothing to enumerate
+  if (board.is_solved()) {
+    deduced.clear();
+    return;
+  }
 
-  std::vector<std::pair<int, int>> cell_list;
+  deduce_from_mine_count(board, mine_count, deduced);
+  if (!deduced.empty()) {
+    stats.mine_count += deduced.size();
+    record_tiers(deduced, DeductionTier::mine_count);
+    return;
+  }
+
+  std::optional<MineProbabilities> probabilities =
+      mine_probabilities(board, mine_count);
+  if (!probabilities.has_value()) {
+    return;
+  }
+  for (int r = 0; r < board.height(); ++r) {
+    for (int c = 0; c < board.width(); ++c) {
+      int idx = board.index(r, c);
+      if (!board.is_revealed(idx) && !board.is_flagged(idx) &&
+          probabilities->forced[idx] != -1) {
+        deduced.emplace_back(idx, probabilities->forced[idx]);
+      }
+    }
+  }
+  stats.enumeration += deduced.size();
+  record_tiers(deduced, DeductionTier::enumeration);
+
+  if (enable_logging && !deduced.empty()) {
+    std::cout << "enumeration resolved " << deduced.size() << " cells"
+              << std::endl;
+  }
+}
+
+void Solver::deduce_from_mine_count(SolverState &board, int mine_count,
+                                    std::vector<std::pair<int, int>> &deduced) {
+  deduced.clear();
+
+  SparseSystem &system = frontier_system;
+  generate_linear_equations(board, system);
+
+  // Subtract equations from the mine count equation, smallest first so that
+  // more of them fit, while their variables are still in it. Ties keep their
+  // order, std::stable_sort would allocate a buffer each call
+  std::vector<int> &rows = mine_count_rows;
+  rows.resize(system.num_equations());
+  std::iota(rows.begin(), rows.end(), 0);
+  auto row_size = [&](int row) {
+    return system.row_offsets[row + 1] - system.row_offsets[row];
+  };
+  std::sort(rows.begin(), rows.end(), [&](int a, int b) {
+    return std::pair(row_size(a), a) < std::pair(row_size(b), b);
+  });
+
+  int mines_left = mine_count;
+  std::vector<char> &covered = covered_variables;
+  covered.assign(system.num_variables(), 0);
+  for (int row : rows) {
+    auto begin = system.columns.begin() + system.row_offsets[row];
+    auto end = system.columns.begin() + system.row_offsets[row + 1];
+    if (std::any_of(begin, end, [&](int var) { return covered[var]; })) {
+      continue;
+    }
+    for (auto it = begin; it != end; ++it) {
+      covered[*it] = 1;
+    }
+    mines_left -= system.target_sums[row];
+  }
+
+  // What is left of it covers every unknown cell outside those equations
+  int num_left = 0;
+  for (int r = 0; r < board.height(); ++r) {
+    for (int c = 0; c < board.width(); ++c) {
+      int idx = board.index(r, c);
+      if (board.is_flagged(idx)) {
+        mines_left -= 1;
+      } else if (!board.is_revealed(idx) &&
+                 (variable_of_cell[idx] == -1 ||
+                  !covered[variable_of_cell[idx]])) {
+        num_left += 1;
+      }
+    }
+  }
+
+  if (num_left == 0 || (mines_left != 0 && mines_left != num_left)) {
+    return;
+  }
+
+  int value = mines_left == 0 ? 0 : 1;
+  for (int r = 0; r < board.height(); ++r) {
+    for (int c = 0; c < board.width(); ++c) {
+      int idx = board.index(r, c);
+      if (!board.is_flagged(idx) && !board.is_revealed(idx) &&
+          (variable_of_cell[idx] == -1 || !covered[variable_of_cell[idx]])) {
+        deduced.emplace_back(idx, value);
+      }
+    }
+  }
+
+  if (enable_logging) {
+    std::cout << "the mine count forces " << deduced.size() << " cells to "
+              << value << std::endl;
+  }
+}
+
+
+std::vector<int> Solver::candidate_starts(const Board &board) {
+  std::vector<int> cell_list;
 
   // Generate a list of all possible cells
-  for (int r = 0; r < board_height; ++r) {
-    for (int c = 0; c < board_width; ++c) {
-      cell_list.emplace_back(r, c);
+  for (int r = 0; r < board.height(); ++r) {
+    for (int c = 0; c < board.width(); ++c) {
+      cell_list.push_back(board.index(r, c));
     }
   }
 
   // Randomly shuffle the list of cells
-  std::random_device rd;
-  std::mt19937 g(rd());
-  std::shuffle(cell_list.begin(), cell_list.end(), g);
+  rng.shuffle(cell_list.begin(), cell_list.end());
 
-  int cell_idx = 0;
+  // temporarily force the starting cell to be zero
+  // this has to be true to be ngs in most cases because when you open a
+  // non-zero number it's usually the case that nothing else opens?
+  auto is_zero = [&](int idx) {
+    int r = board.row_of(idx);
+    int c = board.col_of(idx);
+    return board.in_bounds(r, c) && !board[idx].is_mine &&
+           board[idx].adjacent_mines == 0;
+  };
 
-  bool found_ng_solvable_position = false;
-  auto original_board = board;
-  auto work_board = board;
+  // Keep the first zero cell of each opening, the rest of an opening is
+  // flooded so it is never picked again
+  std::vector<char> seen(board.padded_size(), 0);
+  std::vector<int> starts;
+  std::vector<int> stack;
+  for (int idx : cell_list) {
+    if (seen[idx] || !is_zero(idx)) {
+      continue;
+    }
+    starts.push_back(idx);
+    seen[idx] = 1;
+    stack.push_back(idx);
+    while (!stack.empty()) {
+      int current = stack.back();
+      stack.pop_back();
+      for (int offset : board.neighbour_offsets()) {
+        int n_idx = current + offset;
+        if (!seen[n_idx] && is_zero(n_idx)) {
+          seen[n_idx] = 1;
+          stack.push_back(n_idx);
+        }
+      }
+    }
+  }
+  return starts;
+}
 
-  int row, col;
+bool Solver::solves_from(int start_idx, int mine_count,
+                         std::stop_token stop) {
+  // the numbers stay, forgetting the previous attempt clears a few words
+  state.clear();
+  last_profile.starts_tried++;
 
-  while (not found_ng_solvable_position) {
+  // Start with the selected cell, the opening is all the solver has seen
+  state.reveal_opening(start_idx, revealed_cells);
 
-    if (cell_idx == total_cells) {
-      std::cout << "tried all cells, nothing was found" << std::endl;
-      return std::nullopt;
+  if (enable_logging) {
+    std::cout << "found a starting position = (" << state.row_of(start_idx)
+              << ", " << state.col_of(start_idx) << "),  opening there"
+              << std::endl;
+
+    print_board(state);
+  }
+
+  return continue_solving(state, mine_count, stop);
+}
+
+void Solver::start_profile() {
+  last_profile = {};
+  if (profiling) {
+    profile_start = std::chrono::steady_clock::now();
+    allocations_at_start = thread_allocation_count();
+  }
+}
+
+void Solver::finish_profile() {
+  if (profiling) {
+    last_profile.allocations += thread_allocation_count() - allocations_at_start;
+    last_profile.total_seconds = std::chrono::duration<double>(
+                                     std::chrono::steady_clock::now() -
+                                     profile_start)
+                                     .count();
+  }
+}
+
+bool Solver::solve_from_state(Board &board, int mine_count,
+                              std::stop_token stop) {
+  start_profile();
+  state.assign(board);
+  state.copy_known(board);
+  revealed_cells.clear();
+  for (int r = 0; r < board.height(); ++r) {
+    for (int c = 0; c < board.width(); ++c) {
+      int idx = board.index(r, c);
+      if (board[idx].is_revealed) {
+        revealed_cells.push_back(idx);
+      }
+    }
+  }
+  bool solved = continue_solving(state, mine_count, stop);
+  state.apply_to(board);
+  finish_profile();
+  return solved;
+}
+
+void Solver::record_tiers(const std::vector<std::pair<int, int>> &deduced,
+                          DeductionTier tier) {
+  if (tracing) {
+    for (const auto &[idx, value] : deduced) {
+      last_trace.cell_tiers[idx] = tier;
+    }
+  }
+}
+
+void Solver::record_system_size(int rows, int columns) {
+  last_profile.max_rows = std::max(last_profile.max_rows, rows);
+  last_profile.max_columns = std::max(last_profile.max_columns, columns);
+  if (tracing) {
+    last_trace.max_rows = std::max(last_trace.max_rows, rows);
+    last_trace.max_columns = std::max(last_trace.max_columns, columns);
+  }
+}
+
+bool Solver::continue_solving(SolverState &board, int mine_count,
+                              std::stop_token stop) {
+  if (tracing) {
+    last_trace.max_rows = 0;
+    last_trace.max_columns = 0;
+    std::vector<DeductionTier> &tiers = last_trace.cell_tiers;
+    tiers.assign(board.padded_size(), DeductionTier::unresolved);
+    for (int r = 0; r < board.height(); ++r) {
+      for (int c = 0; c < board.width(); ++c) {
+        int idx = board.index(r, c);
+        if (board.is_revealed(idx) || board.is_flagged(idx)) {
+          tiers[idx] = DeductionTier::given;
+        }
+      }
     }
+  }
 
-    // reset the board and try again
-    work_board = original_board;
+  if (backend == EliminationBackend::incremental) {
+    deduce_incrementally(board, mine_count, stop);
+  } else {
+    deduce_until_stuck(board, mine_count, stop);
+  }
 
-    bool found_safe_initial_cell = false;
+  // if we can't make any more progress then the we are either not ngsolvable
+  // and we go stuck or the board is completely solved
+  return board.is_solved();
+}
 
-    while (not found_safe_initial_cell and cell_idx < total_cells) {
-      // TODO about to iterate through cell list till we find one, if we can't
-      // stop, also if we ge to the end of cell list we stop as well.
-      row = cell_list[cell_idx].first;
-      col = cell_list[cell_idx].second;
+int Solver::find_start_in_parallel(const Board &board,
+                                   const std::vector<int> &starts,
+                                   int mine_count, std::stop_token stop) {
+  int num_starts = starts.size();
+  int num_workers = std::min(jobs, num_starts);
 
-      auto cell = work_board[row][col];
+  // Starts are handed out in order and the lowest solving one wins, attempts
+  // on later starts are stopped as soon as an earlier one succeeds
+  std::atomic<int> next_start{0};
+  std::atomic<int> best{INT_MAX};
+  std::mutex in_flight_mutex;
+  std::vector<int> in_flight(num_workers, INT_MAX);
+  std::vector<std::stop_source> attempt_stops(num_workers);
 
-      // temporarily force the starting cell to be zero
-      // this has to be true to be ngs in most cases because when you open a
-      // non-zero number it's usually the case that nothing else opens?
-      if (not cell.is_mine && cell.adjacent_mines == 0) {
-        found_safe_initial_cell = true;
-      } else {
-        cell_idx += 1;
+  auto worker = [&](int id) {
+    Solver solver(backend, false);
+    solver.set_profiling(profiling);
+    solver.set_tracing(tracing);
+    solver.start_profile();
+    solver.state.assign(board);
+    while (not stop.stop_requested()) {
+      int k = next_start++;
+      if (k >= num_starts || k > best) {
+        break;
+      }
+      std::stop_source attempt_stop;
+      {
+        std::lock_guard lock(in_flight_mutex);
+        in_flight[id] = k;
+        attempt_stops[id] = attempt_stop;
+      }
+      std::stop_callback forward_stop(stop,
+                                      [&] { attempt_stop.request_stop(); });
+
+      if (solver.solves_from(starts[k], mine_count,
+                             attempt_stop.get_token())) {
+        std::lock_guard lock(in_flight_mutex);
+        if (k < best) {
+          best = k;
+          if (tracing) {
+            last_trace = solver.last_trace;
+          }
+          for (int other = 0; other < num_workers; ++other) {
+            if (in_flight[other] > k) {
+              attempt_stops[other].request_stop();
+            }
+          }
+        }
       }
     }
+    solver.finish_profile();
+    std::lock_guard lock(in_flight_mutex);
+    stats += solver.stats;
+    solver.last_profile.total_seconds = 0; // the caller times the whole solve
+    last_profile += solver.last_profile;
+  };
 
-    if (cell_idx == total_cells) {
+  {
+    std::vector<std::jthread> workers;
+    for (int id = 0; id < num_workers; ++id) {
+      workers.emplace_back(worker, id);
+    }
+  } // the workers join here
+
+  return best == INT_MAX ? -1 : best.load();
+}
+
+int Solver::find_start(const Board &board, const std::vector<int> &starts,
+                       int mine_count, std::stop_token stop) {
+  if (jobs > 1 && starts.size() > 1) {
+    return find_start_in_parallel(board, starts, mine_count, stop);
+  }
+  for (int k = 0; k < static_cast<int>(starts.size()); ++k) {
+    if (stop.stop_requested()) {
+      break;
+    }
+    if (solves_from(starts[k], mine_count, stop)) {
+      return k;
+    }
+  }
+  return -1;
+}
+
+std::optional<std::pair<int, int>>
+Solver::solve(const Board &board, int mine_count, std::stop_token stop) {
+  start_profile();
+  std::vector<int> starts = candidate_starts(board);
+  state.assign(board);
+  int found = find_start(board, starts, mine_count, stop);
+  finish_profile();
+
+  if (found == -1) {
+    if (enable_logging) {
       std::cout << "tried all cells, nothing was found" << std::endl;
-      return std::nullopt;
     }
+    return std::nullopt;
+  }
+
+  int row = board.row_of(starts[found]);
+  int col = board.col_of(starts[found]);
+
+  if (enable_logging) {
+    std::cout << "ng solvable from (row, col) = (" << row << ", " << col
+              << ")" << std::endl;
+  }
 
-    // Start with the selected cell
-    reveal_cell(work_board, row, col);
+  return std::pair(row, col);
+}
 
-    std::cout << "found a starting position = (" << row << ", " << col
-              << "),  opening there" << std::endl;
+// One bit per board of a batch of up to 64 boards of the same size, for each
+// padded cell. The sentinel border is revealed in every lane, and lanes
+// without a board are revealed everywhere so they never deduce anything
+struct BoardLanes {
+  std::vector<std::uint64_t> mine;
+  std::vector<std::uint64_t> revealed;
+  std::vector<std::uint64_t> flagged;
+  std::array<std::vector<std::uint64_t>, 4> number; ///< Bit k of adjacent_mines.
+};
+
+// Adds one bit per lane to the 4-bit counters sliced across count
+static void add_lane_bit(std::array<std::uint64_t, 4> &count,
+                         std::uint64_t bit) {
+  for (std::uint64_t &slice : count) {
+    std::uint64_t carry = slice & bit;
+    slice ^= bit;
+    bit = carry;
+  }
+}
+
+// Runs the saturation rule on every lane until no lane changes. A revealed
+// cell whose flagged neighbours match its number reveals the rest, one whose
+// hidden neighbours match it flags them, and revealing a zero floods the
+// opening the same way. Cells are updated in place as the scan reaches them
+template <class Shape>
+static long saturate_lanes(BoardLanes &lanes, Shape shape,
+                           std::stop_token stop) {
+  long deduced = 0;
+  bool changed = true;
+  while (changed && not stop.stop_requested()) {
+    changed = false;
+    for (int r = 0; r < shape.height; ++r) {
+      int idx = shape.index(r, 0);
+      for (int c = 0; c < shape.width; ++c, ++idx) {
+        std::uint64_t source = lanes.revealed[idx] & ~lanes.mine[idx];
+        if (source == 0) {
+          continue;
+        }
+        std::array<std::uint64_t, 4> flags{};
+        std::array<std::uint64_t, 4> hidden{};
+        std::uint64_t unknown = 0;
+        for (int offset : shape.offsets) {
+          int n_idx = idx + offset;
+          add_lane_bit(flags, lanes.flagged[n_idx]);
+          add_lane_bit(hidden, ~lanes.revealed[n_idx]);
+          unknown |= ~lanes.revealed[n_idx] & ~lanes.flagged[n_idx];
+        }
+        source &= unknown;
+        if (source == 0) {
+          continue;
+        }
+        std::uint64_t flags_differ = 0;
+        std::uint64_t hidden_differ = 0;
+        for (int k = 0; k < 4; ++k) {
+          flags_differ |= flags[k] ^ lanes.number[k][idx];
+          hidden_differ |= hidden[k] ^ lanes.number[k][idx];
+        }
+        std::uint64_t safe = source & ~flags_differ;
+        std::uint64_t mines = source & ~hidden_differ & ~safe;
+        if ((safe | mines) == 0) {
+          continue;
+        }
+        for (int offset : shape.offsets) {
+          int n_idx = idx + offset;
+          std::uint64_t open =
+              ~lanes.revealed[n_idx] & ~lanes.flagged[n_idx];
+          lanes.revealed[n_idx] |= open & safe;
+          lanes.flagged[n_idx] |= open & mines;
+          deduced += std::popcount(open & (safe | mines));
+        }
+        changed = true;
+      }
+    }
+  }
+  return deduced;
+}
 
-    print_board(work_board);
+std::vector<std::optional<std::pair<int, int>>>
+Solver::solve_batch(std::span<const Board> boards, std::stop_token stop) {
+  start_profile();
+  std::vector<std::optional<std::pair<int, int>>> results(boards.size());
+  if (boards.empty()) {
+    finish_profile();
+    return results;
+  }
+  const Board &first = boards.front();
+  for (const Board &board : boards) {
+    if (board.width() != first.width() || board.height() != first.height()) {
+      throw std::invalid_argument("Boards of a batch differ in size");
+    }
+  }
 
-    bool cant_make_progress = false;
+  int padded_size = first.padded_size();
+  BoardLanes lanes;
+  std::vector<std::vector<int>> starts;
+  for (std::size_t begin = 0; begin < boards.size(); begin += 64) {
+    std::size_t count = std::min<std::size_t>(64, boards.size() - begin);
+    std::uint64_t used = count == 64 ? ~0ull : (1ull << count) - 1;
 
-    while (not cant_make_progress) {
-      auto equations = generate_linear_equations(work_board, mine_count);
-      auto augmented_matrix = create_augmented_matrix(
-          equations, work_board.size() * work_board[0].size());
+    // The starts are drawn in board order, as one solve() after another would
+    starts.clear();
+    for (std::size_t lane = 0; lane < count; ++lane) {
+      starts.push_back(candidate_starts(boards[begin + lane]));
+    }
 
-      /* print_matrix(augmented_matrix); */
+    lanes.mine.assign(padded_size, 0);
+    lanes.revealed.assign(padded_size, ~0ull);
+    lanes.flagged.assign(padded_size, 0);
+    for (auto &slice : lanes.number) {
+      slice.assign(padded_size, 0);
+    }
+    for (int r = 0; r < first.height(); ++r) {
+      for (int c = 0; c < first.width(); ++c) {
+        int idx = first.index(r, c);
+        lanes.revealed[idx] = ~used;
+        for (std::size_t lane = 0; lane < count; ++lane) {
+          const Cell &cell = boards[begin + lane][idx];
+          std::uint64_t bit = 1ull << lane;
+          lanes.mine[idx] |= cell.is_mine ? bit : 0;
+          for (int k = 0; k < 4; ++k) {
+            lanes.number[k][idx] |= (cell.adjacent_mines >> k & 1) ? bit : 0;
+          }
+        }
+      }
+    }
+    for (std::size_t lane = 0; lane < count; ++lane) {
+      if (!starts[lane].empty()) {
+        lanes.revealed[starts[lane].front()] |= 1ull << lane;
+        last_profile.starts_tried++;
+      }
+    }
 
-      gaussian_elimination(augmented_matrix,
-                           work_board.size() * work_board[0].size());
+    {
+      PhaseTimer timer(phase_seconds(&SolveProfile::local_seconds));
+      stats.local += dispatch_shape(first, [&](auto shape) {
+        return saturate_lanes(lanes, shape, stop);
+      });
+    }
 
-      /* std::cout << "after gaussian elimination" << std::endl; */
+    std::uint64_t stuck = 0;
+    for (int r = 0; r < first.height(); ++r) {
+      for (int c = 0; c < first.width(); ++c) {
+        int idx = first.index(r, c);
+        stuck |= ~lanes.revealed[idx] & ~lanes.flagged[idx];
+      }
+    }
 
-      /* print_matrix(augmented_matrix); */
+    for (std::size_t lane = 0; lane < count && not stop.stop_requested();
+         ++lane) {
+      const Board &board = boards[begin + lane];
+      const std::vector<int> &board_starts = starts[lane];
+      if (board_starts.empty()) {
+        continue;
+      }
+      std::uint64_t bit = 1ull << lane;
+      bool solved = (stuck & bit) == 0;
 
-      auto deduced_vars = deduce_variables(
-          augmented_matrix, work_board.size() * work_board[0].size());
+      if (!solved) {
+        // Drop out to the full pipeline from where the lane got stuck
+        state.assign(board);
+        revealed_cells.clear();
+        for (int r = 0; r < board.height(); ++r) {
+          for (int c = 0; c < board.width(); ++c) {
+            int idx = board.index(r, c);
+            if (lanes.revealed[idx] & bit) {
+              state.reveal(idx);
+              revealed_cells.push_back(idx);
+            } else if (lanes.flagged[idx] & bit) {
+              state.set_flagged(idx, true);
+            }
+          }
+        }
+        solved = continue_solving(state, board.mine_count(), stop);
+      }
 
-      if (deduced_vars.empty()) {
-        std::cerr << "No variables could be deduced. Trying a new cell..."
-                  << std::endl;
-        cant_make_progress = true;
-        cell_idx += 1;
-      } else {
-        update_board(work_board, deduced_vars);
-        std::cout << "just updated board with information" << std::endl;
-        print_board(work_board);
+      int found = 0;
+      if (!solved) {
+        std::vector<int> rest(board_starts.begin() + 1, board_starts.end());
+        found = find_start(board, rest, board.mine_count(), stop);
+        found = found == -1 ? -1 : found + 1;
+      }
+      if (found != -1) {
+        results[begin + lane] =
+            std::pair(board.row_of(board_starts[found]),
+                      board.col_of(board_starts[found]));
       }
     }
-    // if we can't make any more progress then the we are either not ngsolvable
-    // and we go stuck or the board is completely solved
-    found_ng_solvable_position = is_board_solved(work_board);
   }
 
-  std::cout << "ng solvable from (row, col) = (" << row << ", " << col << ")"
-            << std::endl;
-
+  finish_profile();
+  return results;
+}
 
-  return std::pair(row, col);
+void print_board(const SolverState &board) {
+  for (int r = 0; r < board.height(); ++r) {
+    for (int c = 0; c < board.width(); ++c) {
+      int idx = board.index(r, c);
+      if (board.is_revealed(idx)) {
+        std::cout << board.number(idx);
+      } else if (board.is_flagged(idx)) {
+        std::cout << 'F';
+      } else {
+        std::cout << '#';
+      }
+    }
+    std::cout << std::endl;
+  }
 }
 
-void print_board(std::vector<std::vector<Cell>> &board) {
-  for (const auto &row : board) {
-    for (const auto &cell : row) {
+void print_board(const Board &board) {
+  for (int r = 0; r < board.height(); ++r) {
+    for (int c = 0; c < board.width(); ++c) {
+      const Cell &cell = board.at(r, c);
       if (cell.is_revealed) {
         if (cell.is_mine) {
           std::cout << 'M';
         } else {
-          std::cout << cell.adjacent_mines;
+          std::cout << static_cast<int>(cell.adjacent_mines);
         }
       } else if (cell.is_flagged) {
         std::cout << 'F';
@@ -3,48 +3,436 @@
 
 #include "linear_system_solver.hpp"
 #include "game_logic.hpp"
+#include "solver_state.hpp"
+#include <array>
+#include <chrono>
 #include <optional>
+#include <span>
 #include <vector>
 #include <set>
+#include <string>
 #include <unordered_map>
-#include <random>
+#include <cstdint>
+#include <stop_token>
 
-void print_board(std::vector<std::vector<Cell>> &board);
+void print_board(const Board &board);
+void print_board(const SolverState &board);
+
+/**
+ * @brief Selects how the solver reduces its system of equations.
+ */
+enum class EliminationBackend {
+    dense,       ///< Reference exact integer row reduction over the full augmented matrix.
+    bitset,      ///< Bit-packed sign mask rows, see BitsetRow.
+    incremental, ///< Bit-packed rows kept reduced across rounds, see IncrementalSystem.
+};
+
+/**
+ * @brief How many cells each tier of the deduction pipeline resolved.
+ *
+ * A round runs the local rules first, then elimination on what they left,
+ * and only when both are stuck the mine count and then enumeration.
+ */
+struct DeductionStats {
+    long local = 0;       ///< Saturated equations and subset pairs, see Solver::deduce_locally().
+    long elimination = 0; ///< Row reduction by the selected backend.
+    long mine_count = 0;  ///< The global mine count, see Solver::deduce_from_mine_count().
+    long enumeration = 0; ///< Exact enumeration of the placements, see mine_probabilities().
+
+    DeductionStats &operator+=(const DeductionStats &other);
+};
+
+/**
+ * @brief What one call of Solver::solve() or Solver::solve_from_state() did.
+ *
+ * The counts are always kept. The times, in seconds, and the allocations are
+ * only measured while profiling is enabled, see Solver::set_profiling(), the
+ * allocations only in programs which count them, see
+ * allocation_counting_available(). With several jobs everything but
+ * total_seconds is summed over the threads.
+ */
+struct SolveProfile {
+    long starts_tried = 0; ///< Starts opened, each is a full attempt.
+    long rounds = 0;       ///< Deduction rounds over every attempt.
+    long equations = 0;    ///< Equations generated over every round.
+    int max_rows = 0;      ///< Rows of the largest system that was reduced.
+    int max_columns = 0;   ///< Columns of the largest system, for the incremental backend its unknowns, see IncrementalSystem::num_columns().
+
+    double generate_equations_seconds = 0; ///< generate_linear_equations(), or adding rows to the incremental system.
+    double build_matrix_seconds = 0;       ///< create_augmented_matrix() or create_bitset_matrix().
+    double elimination_seconds = 0;        ///< gaussian_elimination(), or IncrementalSystem::deduce().
+    double deduce_variables_seconds = 0;   ///< deduce_variables(), part of IncrementalSystem::deduce() for that backend.
+    double local_seconds = 0;              ///< Solver::deduce_locally().
+    double stuck_seconds = 0;              ///< The mine count and enumeration tiers.
+    double total_seconds = 0;
+    long allocations = 0;                  ///< Calls of operator new on the solving threads, 0 when not counted.
+
+    SolveProfile &operator+=(const SolveProfile &other);
+
+    /**
+     * @brief The profile as one line of JSON, the keys are the member names.
+     *
+     * allocations is left out when the program does not count them.
+     */
+    std::string to_json() const;
+};
+
+/**
+ * @brief The tier of the deduction pipeline which resolved a cell, from the
+ * easiest to the hardest, see Solver::set_tracing().
+ */
+enum class DeductionTier : std::uint8_t {
+    unresolved,  ///< Never resolved, and every sentinel.
+    given,       ///< Known before deducing, the opening of the start or what solve_from_state() was given.
+    local,       ///< DeductionStats::local.
+    elimination, ///< DeductionStats::elimination.
+    mine_count,  ///< DeductionStats::mine_count.
+    enumeration, ///< DeductionStats::enumeration.
+};
+
+/**
+ * @brief One attempt of a solve, recorded while tracing, see
+ * Solver::set_tracing().
+ */
+struct SolveTrace {
+    std::vector<DeductionTier> cell_tiers; ///< Tier which resolved each cell, by padded index.
+    int max_rows = 0;    ///< Rows of the largest system the attempt reduced.
+    int max_columns = 0; ///< Columns of the largest system, see SolveProfile::max_columns.
+};
 
 class Solver {
 public:
 
+    /**
+     * @brief Creates a solver using the given elimination backend.
+     *
+     * A solver owns its scratch buffers, so a solver must not be shared
+     * between threads but each thread can run its own.
+     *
+     * @param backend The backend used to reduce each round's equations.
+     * @param enable_logging Boolean to enable or disable printing the solve progress.
+     * @param jobs Number of threads used to try starting regions of one board.
+     * @param seed Seed of the order the starts are tried in.
+     */
+    explicit Solver(EliminationBackend backend = EliminationBackend::incremental,
+                    bool enable_logging = true, int jobs = 1, std::uint64_t seed = 0);
+
+    /**
+     * @brief Restarts the order the starts are tried in from a new seed.
+     */
+    void reseed(std::uint64_t seed) { rng.reseed(seed); }
+
     /**
      * @brief Starts the solving process.
+     *
+     * Every zero cell of one opening reveals the same cells, so only one start
+     * per opening is tried. With more than one job the openings are tried
+     * concurrently, and the result is the same as trying them one by one.
+     * Only the layout of board is read, the solver deduces on a SolverState
+     * of its own, so the board is never written and what is revealed or
+     * flagged on it is ignored.
      * 
-     * @return True if the board is no-guess solvable, false otherwise.
+     * @param stop Requesting a stop abandons the solve, which then reports no solution.
+     * @return The (row, col) to start from if the board is no-guess solvable,
+     *         std::nullopt otherwise.
      */
-    std::optional<std::pair<int, int>> solve(std::vector<std::vector<Cell>>& board, int mine_count);
+    std::optional<std::pair<int, int>> solve(const Board &board, int mine_count, std::stop_token stop = {});
 
+    /**
+     * @brief Continues deducing on a board which already has cells revealed or flagged.
+     *
+     * The solver deduces on its own SolverState and copies the result back
+     * once, so the board is updated in place and is left where the solver got
+     * stuck, or with every cell revealed or flagged.
+     *
+     * @return True if every cell of the board is revealed or flagged.
+     */
+    bool solve_from_state(Board &board, int mine_count, std::stop_token stop = {});
 
-private:
+    /**
+     * @brief Solves many boards of the same size together.
+     *
+     * Each board is opened at its first start and run through the saturation
+     * rule in lock-step with up to 63 others, one bit per board in each 64-bit
+     * lane of a cell. Boards the rule does not finish continue from where it
+     * stopped on the full pipeline, then on their other starts as solve()
+     * would, and the results are those of calling solve() on each board in
+     * turn. The mine count of each board is read from it.
+     *
+     * @param stop Requesting a stop abandons the boards not decided yet.
+     * @return The (row, col) to start from for each board, std::nullopt for
+     *         boards which are not no-guess solvable.
+     * @throws std::invalid_argument if the boards differ in size.
+     */
+    std::vector<std::optional<std::pair<int, int>>>
+    solve_batch(std::span<const Board> boards, std::stop_token stop = {});
 
     /**
      * @brief Generates linear equations for the current board state.
+     *
+     * Only revealed cells bordering an unrevealed one produce an equation, and
+     * only the unrevealed frontier cells become variables.
      * 
-     * @return Set of linear equations representing the system.
+     * @return Sparse system over the frontier, its variables map to board indices.
+     */
+    SparseSystem generate_linear_equations(const Board &board, int mine_count);
+
+    /**
+     * @brief Cells resolved by each deduction tier since the solver was made or reset.
+     */
+    const DeductionStats &deduction_stats() const { return stats; }
+
+    void reset_deduction_stats() { stats = {}; }
+
+    /**
+     * @brief Turns timing and allocation counting of each solve on or off.
+     *
+     * Off by default, then a solve only bumps the counts of its profile.
+     */
+    void set_profiling(bool enable) { profiling = enable; }
+
+    /**
+     * @brief What the last solve() or solve_from_state() did.
+     */
+    const SolveProfile &profile() const { return last_profile; }
+
+    /**
+     * @brief Turns recording a SolveTrace of each attempt on or off.
+     *
+     * Off by default. After solve() found a start the trace is the attempt
+     * from that start, for any number of jobs, and after solve_from_state()
+     * it is that solve. A solve() which found no start leaves no meaningful
+     * trace, and the lanes of solve_batch() are not traced.
+     */
+    void set_tracing(bool enable) { tracing = enable; }
+
+    /**
+     * @brief The last traced attempt, empty until one ran.
+     */
+    const SolveTrace &trace() const { return last_trace; }
+
+
+private:
+
+    EliminationBackend backend;
+    bool enable_logging;
+    int jobs;
+    Rng rng;
+    DeductionStats stats;
+    bool profiling = false;
+    SolveProfile last_profile;
+    bool tracing = false;
+    SolveTrace last_trace;
+
+    /**
+     * @brief Records the tier of deduced cells when tracing.
+     */
+    void record_tiers(const std::vector<std::pair<int, int>> &deduced, DeductionTier tier);
+
+    /**
+     * @brief Records the size of a system about to be reduced in last_profile
+     * and, when tracing, in last_trace.
+     */
+    void record_system_size(int rows, int columns);
+
+    std::chrono::steady_clock::time_point profile_start;
+    long allocations_at_start = 0;
+
+    /**
+     * @brief Clears last_profile at the start of a solve and, when profiling,
+     * reads the clock and the allocation count.
      */
+    void start_profile();
 
-    std::set<LinearEquation> generate_linear_equations(std::vector<std::vector<Cell>> &board, int mine_count);
+    /**
+     * @brief Adds the time and allocations since start_profile() to last_profile.
+     */
+    void finish_profile();
+
+    /**
+     * @brief Where a PhaseTimer adds its time, nullptr when not profiling.
+     */
+    double *phase_seconds(double SolveProfile::*phase) {
+        return profiling ? &(last_profile.*phase) : nullptr;
+    }
+
+    /// What the current attempt knows of the board, assigned once per board
+    /// and cleared for each start.
+    SolverState state;
+
+    /**
+     * @brief Fills system with the equations of board, reusing its buffers.
+     */
+    void generate_linear_equations(const SolverState &board, SparseSystem &system);
+
+    /**
+     * @brief Picks one start cell per opening of the board.
+     *
+     * @return Padded indices of the starts, in a random order.
+     */
+    std::vector<int> candidate_starts(const Board &board);
+
+    /**
+     * @brief Checks whether the board last assigned to state is no-guess
+     * solvable from one start.
+     *
+     * @param start_idx Padded index of the zero cell to open first.
+     * @return True if every cell could be deduced.
+     */
+    bool solves_from(int start_idx, int mine_count, std::stop_token stop);
+
+    /**
+     * @brief Tries the starts in order on several threads.
+     *
+     * @return Position in starts of the first start that solves the board, -1 if none does.
+     */
+    int find_start_in_parallel(const Board &board, const std::vector<int> &starts, int mine_count, std::stop_token stop);
+
+    /**
+     * @brief Tries the starts of one board from the first, on jobs threads.
+     *
+     * One job deduces on state, which must have been assigned the board.
+     *
+     * @return Position in starts of the first start that solves the board, -1 if none does.
+     */
+    int find_start(const Board &board, const std::vector<int> &starts, int mine_count, std::stop_token stop);
+
+    /// Compact variable id of each padded board index, -1 when it is not a variable.
+    std::vector<int> variable_of_cell;
+
+    /// Scratch buffer generate_linear_equations() sorts the variables in.
+    std::vector<int> variable_order;
+
+    /// System over the frontier, rebuilt by the rounds of the dense and bitset
+    /// backends and by deduce_from_mine_count().
+    SparseSystem frontier_system;
+
+    /// Rows of frontier_system by size and the variables they cover, scratch
+    /// buffers of deduce_from_mine_count().
+    std::vector<int> mine_count_rows;
+    std::vector<char> covered_variables;
+
+    /// Components of the current attempt that deduced nothing, keyed by their equations.
+    std::set<std::vector<int>> stuck_components;
+
+    /// Reduced system over board indices, kept between rounds of the incremental backend.
+    IncrementalSystem incremental_system;
+
+    /// Scratch buffer for the variables of one cell's equation, a cell has at most 8.
+    std::array<int, 8> equation_variables;
+
+    /// Cells revealed since the incremental system last saw the board.
+    std::vector<int> revealed_cells;
+
+    /**
+     * @brief Deduces until stuck, with revealed_cells holding every revealed cell
+     * the solver has not seen yet.
+     *
+     * @return True if the board is completely solved.
+     */
+    bool continue_solving(SolverState &board, int mine_count, std::stop_token stop);
+
+    /**
+     * @brief Deduces as much of the board as possible by rebuilding the system each round.
+     *
+     * The system is split into its connected components, each reduced on its
+     * own. A component which deduced nothing is skipped until one of its
+     * equations changes.
+     */
+    void deduce_until_stuck(SolverState &board, int mine_count, std::stop_token stop);
+
+    /**
+     * @brief Deduces as much of the board as possible with the incremental system.
+     *
+     * The first round adds the equations of revealed_cells, after that only the
+     * cells revealed in the previous round add equations, and the values of
+     * flagged and revealed cells are substituted into the rows already reduced.
+     */
+    void deduce_incrementally(SolverState &board, int mine_count, std::stop_token stop);
+
+    /**
+     * @brief Deduces cells from the global mine count once the equations are stuck.
+     *
+     * The mine count is an equation over every unknown cell, which would make
+     * the system dense, so it is kept out of it. Instead it is reduced here by
+     * subtracting frontier equations with disjoint variables, which keeps its
+     * coefficients 0 or 1. When the unknown cells left in it must hold no mine,
+     * or must all be mines, they are deduced.
+     *
+     * @param deduced Cleared, then filled with (padded board index, value) pairs.
+     */
+    void deduce_from_mine_count(SolverState &board, int mine_count,
+                                std::vector<std::pair<int, int>> &deduced);
+
+    /**
+     * @brief Runs the saturation and subset rules over the equations of changed cells.
+     *
+     * An equation whose target is 0, or the number of its unknowns, resolves
+     * all of them. When the unknowns of one equation are a subset of another's
+     * within two cells, the rest of the larger one holds the difference of
+     * their targets, which resolves it the same way. Resolved cells are applied
+     * to the board and queue their neighbours' equations until nothing changes.
+     *
+     * @param changed Padded indices of the cells revealed or flagged since the last call.
+     * @param deduced Cleared, then filled with (padded board index, value) pairs.
+     */
+    void deduce_locally(SolverState &board, const std::vector<int> &changed,
+                        std::vector<std::pair<int, int>> &deduced);
+
+    /**
+     * @brief The last tiers, tried when local rules and elimination are stuck.
+     *
+     * The mine count rule is tried first, then exact enumeration. A solved
+     * board tries neither. Only enumeration allocates, through
+     * mine_probabilities(), so once the scratch buffers have grown the rounds
+     * of the incremental backend allocate nothing until one has to enumerate.
+     *
+     * @param deduced Cleared, then filled with (padded board index, value) pairs.
+     */
+    void deduce_when_stuck(SolverState &board, int mine_count,
+                           std::vector<std::pair<int, int>> &deduced);
+
+    /// Cells resolved in the current round, by the local rules and by the last tiers.
+    std::vector<std::pair<int, int>> local_deduced;
+    std::vector<std::pair<int, int>> stuck_deduced;
+
+    /// Cells revealed or flagged in the previous round.
+    std::vector<int> changed_cells;
+
+    /// Revealed cells whose equation deduce_locally() still has to look at.
+    std::vector<int> local_worklist;
+    std::vector<char> in_local_worklist;
+
+    /**
+     * @brief Adds the equation of a revealed cell to the incremental system.
+     *
+     * @param idx Padded board index of the revealed cell.
+     */
+    void add_cell_equation(const SolverState &board, int idx);
+
+    /**
+     * @brief Reduces the equations with the selected backend and deduces what it can.
+     *
+     * @param system The equations for the current board state.
+     * @return Map of compact variable ids to their deduced values.
+     */
+    std::unordered_map<int, int> deduce(const SparseSystem &system);
 
     /**
      * @brief Updates the board based on the deduced variable values.
      * 
-     * @param deduced_vars Map of variable indices to their deduced values.
+     * @param system The system the variables were deduced from.
+     * @param deduced_vars Map of compact variable ids to their deduced values.
      */
-    void update_board(std::vector<std::vector<Cell>> &board, const std::unordered_map<int, int> &deduced_vars);
+    void update_board(SolverState &board, const SparseSystem &system, const std::unordered_map<int, int> &deduced_vars);
 
     /**
-     * @brief Checks if the current state of the board is solved.
+     * @brief Updates the board based on deduced cell values.
      * 
-     * @return True if the board is solved, false otherwise.
+     * @param deduced_cells (padded board index, value) pairs of the deduced cells.
      */
-    bool is_board_solved(std::vector<std::vector<Cell>> &board);
+    void update_board(SolverState &board, const std::vector<std::pair<int, int>> &deduced_cells);
+
 
 };
 
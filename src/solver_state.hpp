@@ -0,0 +1,224 @@
+#ifndef SOLVER_STATE_HPP
+#define SOLVER_STATE_HPP
+
+#include "game_logic.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief What the solver knows of a board: the numbers of its cells, and
+ * which cells are revealed and which are known mines.
+ *
+ * Indices are the padded ones of Board. Knowledge is two bitsets of one bit
+ * per padded cell, so forgetting an attempt is a copy of a few words and the
+ * numbers, which no attempt changes, are only copied once per board. Reading
+ * a cell through operator[] gives a Cell with just is_revealed, is_flagged
+ * and adjacent_mines set, so code written against the read side of Board
+ * runs on either. The sentinel border is revealed, like on a Board.
+ */
+class SolverState {
+public:
+  /**
+   * @brief Takes the size and numbers of board with nothing known yet,
+   * reusing the buffers of the previous board.
+   */
+  void assign(const Board &board) {
+    height_ = board.height();
+    width_ = board.width();
+    offsets_ = board.neighbour_offsets();
+    int padded_size = board.padded_size();
+    int words = (padded_size + 63) / 64;
+    numbers_.resize(padded_size);
+    border_.assign(words, 0);
+    revealed_.assign(words, 0);
+    flagged_.assign(words, 0);
+    known_ = 0;
+    const Cell *cells = board.data();
+    for (int idx = 0; idx < padded_size; ++idx) {
+      numbers_[idx] = cells[idx].adjacent_mines;
+    }
+    auto set_border = [&](int idx) {
+      border_[idx >> 6] |= bit(idx);
+      numbers_[idx] = 0;
+    };
+    // The top and bottom padding rows, then the two ends of every row between
+    int last_row = padded_size - stride();
+    for (int idx = 0; idx < stride(); ++idx) {
+      set_border(idx);
+      set_border(last_row + idx);
+    }
+    for (int idx = stride() - 1; idx < last_row; idx += stride()) {
+      set_border(idx);
+      set_border(idx + 1);
+    }
+    clear();
+  }
+
+  /**
+   * @brief Adds what is revealed and flagged on board, which must be the one
+   * last passed to assign().
+   */
+  void copy_known(const Board &board) {
+    for (int r = 0; r < height_; ++r) {
+      for (int c = 0; c < width_; ++c) {
+        int idx = index(r, c);
+        if (board[idx].is_revealed) {
+          reveal(idx);
+        } else if (board[idx].is_flagged) {
+          set_flagged(idx, true);
+        }
+      }
+    }
+  }
+
+  /**
+   * @brief Forgets every revealed and flagged playing cell.
+   */
+  void clear() {
+    std::copy(border_.begin(), border_.end(), revealed_.begin());
+    std::fill(flagged_.begin(), flagged_.end(), 0);
+    known_ = 0;
+  }
+
+  int height() const { return height_; }
+  int width() const { return width_; }
+  int cell_count() const { return height_ * width_; }
+  int padded_size() const { return static_cast<int>(numbers_.size()); }
+  int stride() const { return width_ + 2; }
+  int index(int row, int col) const { return (row + 1) * stride() + col + 1; }
+  int row_of(int index) const { return index / stride() - 1; }
+  int col_of(int index) const { return index % stride() - 1; }
+  bool in_bounds(int row, int col) const {
+    return row >= 0 && row < height_ && col >= 0 && col < width_;
+  }
+  const std::array<int, 8> &neighbour_offsets() const { return offsets_; }
+
+  bool is_revealed(int idx) const { return revealed_[idx >> 6] & bit(idx); }
+  bool is_flagged(int idx) const { return flagged_[idx >> 6] & bit(idx); }
+
+  /**
+   * @brief The flagged neighbours of a cell and those neither flagged nor
+   * revealed, as masks with bit k set for neighbour_offsets()[k].
+   *
+   * Reads the three rows around the cell three bits at a time, which is
+   * cheaper than testing the 8 neighbours one by one.
+   */
+  std::pair<unsigned, unsigned> neighbour_masks(int idx) const {
+    unsigned flagged = around(flagged_, idx);
+    unsigned unknown = ~(around(revealed_, idx) | flagged) & 0xff;
+    return {flagged, unknown};
+  }
+
+  /**
+   * @brief Number of mines around a cell, only meaningful once it is revealed.
+   */
+  int number(int idx) const { return numbers_[idx]; }
+
+  Cell operator[](int idx) const {
+    Cell cell;
+    cell.is_revealed = is_revealed(idx);
+    cell.is_flagged = is_flagged(idx);
+    cell.adjacent_mines = numbers_[idx];
+    return cell;
+  }
+
+  void reveal(int idx) {
+    if (!is_revealed(idx)) {
+      revealed_[idx >> 6] |= bit(idx);
+      known_ += 1;
+    }
+  }
+
+  void set_flagged(int idx, bool flagged) {
+    if (is_flagged(idx) != flagged) {
+      flagged_[idx >> 6] ^= bit(idx);
+      known_ += flagged ? 1 : -1;
+    }
+  }
+
+  /**
+   * @brief Reveals a cell, and the whole opening when it is a zero, the way
+   * reveal_cell() plays it on a Board.
+   *
+   * @param revealed Cleared, then filled with the padded indices revealed.
+   */
+  void reveal_opening(int idx, std::vector<int> &revealed) {
+    revealed.clear();
+    if (is_revealed(idx) || is_flagged(idx)) {
+      return;
+    }
+    reveal(idx);
+    revealed.push_back(idx);
+    for (std::size_t next = 0; next < revealed.size(); ++next) {
+      int current = revealed[next];
+      if (numbers_[current] != 0) {
+        continue;
+      }
+      for (int offset : offsets_) {
+        int n_idx = current + offset;
+        if (!is_revealed(n_idx) && !is_flagged(n_idx)) {
+          reveal(n_idx);
+          revealed.push_back(n_idx);
+        }
+      }
+    }
+  }
+
+  /**
+   * @brief True once every playing cell is revealed or flagged.
+   */
+  bool is_solved() const { return known_ == cell_count(); }
+
+  /**
+   * @brief Copies what is known onto a board of the same size, through
+   * reveal() and set_flagged() so its counters stay right.
+   */
+  void apply_to(Board &board) const {
+    for (int r = 0; r < height_; ++r) {
+      for (int c = 0; c < width_; ++c) {
+        int idx = index(r, c);
+        if (is_revealed(idx)) {
+          board.reveal(idx);
+        } else if (is_flagged(idx)) {
+          board.set_flagged(idx, true);
+        }
+      }
+    }
+  }
+
+private:
+  static std::uint64_t bit(int idx) { return std::uint64_t{1} << (idx & 63); }
+
+  // Bits start, start + 1 and start + 2 of a bitset, which can span two words
+  static unsigned three_bits(const std::vector<std::uint64_t> &bits, int start) {
+    int word = start >> 6;
+    int shift = start & 63;
+    std::uint64_t value = bits[word] >> shift;
+    if (shift > 61) {
+      value |= bits[word + 1] << (64 - shift);
+    }
+    return value & 7;
+  }
+
+  // The 8 neighbours of idx in a bitset, in the order of neighbour_offsets()
+  unsigned around(const std::vector<std::uint64_t> &bits, int idx) const {
+    unsigned above = three_bits(bits, idx - stride() - 1);
+    unsigned middle = three_bits(bits, idx - 1);
+    unsigned below = three_bits(bits, idx + stride() - 1);
+    return above | (middle & 1) << 3 | (middle >> 2) << 4 | below << 5;
+  }
+
+  int height_ = 0;
+  int width_ = 0;
+  int known_ = 0; ///< Playing cells revealed or flagged.
+  std::array<int, 8> offsets_{};
+  std::vector<std::uint8_t> numbers_;
+  std::vector<std::uint64_t> border_; ///< The sentinels, revealed from the start.
+  std::vector<std::uint64_t> revealed_;
+  std::vector<std::uint64_t> flagged_;
+};
+
+#endif // SOLVER_STATE_HPP
@@ -0,0 +1,583 @@
+#include "tui.hpp"
+#include "bench.hpp"
+#include "board_analysis.hpp"
+#include "board_archive.hpp"
+#include "board_pool.hpp"
+#include "corpus_validation.hpp"
+#include "no_guess_generator.hpp"
+#include "probability.hpp"
+#include "solver.hpp"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <ctime>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <ncurses.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+void initialize_ncurses() {
+  initscr();
+  keypad(stdscr, TRUE);
+  noecho();
+  curs_set(0);
+
+  start_color();
+  init_pair(1, COLOR_BLACK, COLOR_WHITE);   // Default background
+  init_pair(2, COLOR_BLUE, COLOR_BLACK);    // Number 1
+  init_pair(3, COLOR_GREEN, COLOR_BLACK);   // Number 2
+  init_pair(4, COLOR_YELLOW, COLOR_BLACK);  // Number 3
+  init_pair(5, COLOR_RED, COLOR_BLACK);     // Number 4
+  init_pair(6, COLOR_MAGENTA, COLOR_BLACK); // Number 5
+  init_pair(7, COLOR_CYAN, COLOR_BLACK);    // Number 6
+  init_pair(8, COLOR_MAGENTA, COLOR_BLACK); // Number 7
+  init_pair(9, COLOR_WHITE,
+            COLOR_BLACK); // Number 0 (black background, white text)
+  init_pair(10, COLOR_BLACK, COLOR_MAGENTA); // Cursor (golden with black text)
+  init_pair(11, COLOR_BLACK, COLOR_RED);     // Flag
+}
+
+int get_color_pair(int number, bool is_cursor) {
+  if (is_cursor) {
+    return 10; // Cursor color: gold on black
+  }
+  switch (number) {
+  case 0:
+    return 9; // Black background with white text
+  case 1:
+    return 2; // Blue
+  case 2:
+    return 3; // Green
+  case 3:
+    return 4; // Yellow
+  case 4:
+    return 5; // Red
+  case 5:
+    return 6; // Pink
+  case 6:
+    return 7; // Lime green
+  case 7:
+    return 8; // Purple
+  default:
+    return 1; // Default color for mines or flags
+  }
+}
+
+void draw_cell(const Board &board, int row, int col, bool is_cursor) {
+  const Cell &curr_cell = board.at(row, col);
+  int color_pair = get_color_pair(curr_cell.adjacent_mines, is_cursor);
+
+  // Cells are two characters wide, below the mine counter
+  move(row + 1, col * 2);
+
+  // Draw unopened cells, note all flags are unopened.
+  bool is_untouched = !curr_cell.is_revealed && !curr_cell.is_flagged;
+  // TODO this whole if statement is bad
+  if (is_untouched) {
+    if (is_cursor) {
+      attron(COLOR_PAIR(10));
+      printw("* ");
+      attroff(COLOR_PAIR(10));
+    } else if (curr_cell.safe_start) {
+      attron(COLOR_PAIR(1));
+      printw("X ");
+      attroff(COLOR_PAIR(1));
+    } else {
+      attron(COLOR_PAIR(1));
+      printw("* ");
+      attroff(COLOR_PAIR(1));
+    }
+  } else {
+    if (curr_cell.is_flagged) {
+      if (is_cursor) {
+        attron(COLOR_PAIR(color_pair));
+        printw("F ");
+        attroff(COLOR_PAIR(color_pair));
+      } else {
+        attron(COLOR_PAIR(11));
+        printw("F ");
+        attroff(COLOR_PAIR(11));
+      }
+    } else if (curr_cell.is_mine) {
+      printw("M ");
+    } else {
+      attron(COLOR_PAIR(color_pair));
+      printw("%d ", static_cast<int>(curr_cell.adjacent_mines));
+      attroff(COLOR_PAIR(color_pair));
+    }
+  }
+}
+
+void draw_mine_counter(int remaining_mines) {
+  mvprintw(0, 0, "Remaining mines: %d", remaining_mines);
+  clrtoeol();
+}
+
+void draw_timer(std::chrono::steady_clock::duration elapsed) {
+  long tenths =
+      std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count() /
+      100;
+  mvprintw(0, 24, "Time: %ld:%02ld.%ld", tenths / 600, tenths / 10 % 60,
+           tenths % 10);
+}
+
+void display_board(const Board &board, int cursor_row,
+                   int cursor_col) {
+  draw_mine_counter(board.unflagged_mines());
+
+  for (int row = 0; row < board.height(); row++) {
+    for (int col = 0; col < board.width(); col++) {
+      bool is_cursor = (row == cursor_row && col == cursor_col);
+      draw_cell(board, row, col, is_cursor);
+    }
+  }
+  refresh();
+}
+
+void display_dirty_cells(const Board &board, int cursor_row, int cursor_col,
+                         int previous_cursor_row, int previous_cursor_col,
+                         std::vector<int> &dirty) {
+  draw_mine_counter(board.unflagged_mines());
+
+  for (int idx : dirty) {
+    int row = board.row_of(idx);
+    int col = board.col_of(idx);
+    draw_cell(board, row, col, row == cursor_row && col == cursor_col);
+  }
+  dirty.clear();
+
+  // The cursor cells are drawn last so they win over any dirty cell
+  draw_cell(board, previous_cursor_row, previous_cursor_col,
+            previous_cursor_row == cursor_row &&
+                previous_cursor_col == cursor_col);
+  draw_cell(board, cursor_row, cursor_col, true);
+}
+
+
+void display_help() {
+  std::cout
+      << "Minesweeper Game - Command Line Version\n"
+      << "Usage: minesweeper [OPTIONS]\n"
+      << "Options:\n"
+      << "  --width <value>    Set the width of the board (default: 10)\n"
+      << "  --height <value>   Set the height of the board (default: 10)\n"
+      << "  --mines <value>    Set the number of mines (default: 10)\n"
+      << "  --ng               Produce a no guess board (default: false)\n"
+      << "  --vim              Enable vim mode controls for movement (default: "
+         "false)\n"
+      << "  --file <value>     Loads a minefield from the text file or the first "
+         "board of the board archive, when used with --ng it checks to see if "
+         "the board is ngsolvable\n"
+      << "  --constructive     With --ng, repair one board by moving mines "
+         "instead of regenerating it (default: false)\n"
+      << "  --jobs <value>     Number of threads used to generate or check a no "
+         "guess board (default: 1)\n"
+      << "  --seed <value>     Seed of the board and of the solver, equal seeds "
+         "give equal boards for any --jobs (default: random)\n"
+      << "  --pool <dir>       With --ng, take the board from a pool of "
+         "generated boards in the directory and refill it in the background "
+         "while playing\n"
+      << "  --pool-size <value> Boards of each size and mine count the pool "
+         "keeps (default: 16)\n"
+      << "  --min-3bv <value>  With --ng, only play boards which take at least "
+         "this many clicks to clear, boards outside the range are rejected "
+         "before they are solved\n"
+      << "  --max-3bv <value>  With --ng, only play boards which take at most "
+         "this many clicks to clear\n"
+      << "  --validate <path>  Check every board of an archive, a text file of "
+         "boards separated by blank lines, a directory of those or - for "
+         "stdin, and print one verdict per board, uses --jobs and --seed\n"
+      << "  --bench <value>    Solve this many boards without the interface and "
+         "print statistics, uses --width, --height, --mines or --file\n"
+      << "  --format <value>   Output of --bench, csv or json (default: csv)\n"
+      << "  --backend <value>  Elimination backend of --bench, dense, "
+         "bitset or incremental (default: incremental)\n"
+      << "  --batch <value>    With --bench, solve this many boards at once "
+         "with the batch solver (default: 1)\n"
+      << "  --profile <file>   With --bench, write where each solve spent its "
+         "time as one JSON object per line to the file\n"
+      << "  --help             Display this help message\n";
+}
+
+static_assert(KEY_MAX < key_code_count, "ActionTable misses key codes");
+
+ActionTable create_action_map(int &cursor_row, int &cursor_col,
+                              Board &board, bool &game_over,
+                              int height, int width, int mines_count, bool &vim,
+                              std::vector<int> &dirty, HintTask &hint) {
+
+  // Vim-style map for direction keys
+  KeyMap vim_map = {{Direction::up, static_cast<int>('k')},
+                    {Direction::down, static_cast<int>('j')},
+                    {Direction::left, static_cast<int>('h')},
+                    {Direction::right, static_cast<int>('l')}};
+
+  KeyMap regular_map = {{Direction::up, KEY_UP},
+                        {Direction::down, KEY_DOWN},
+                        {Direction::left, KEY_LEFT},
+                        {Direction::right, KEY_RIGHT}};
+
+  KeyMap selected_map = vim ? vim_map : regular_map;
+
+  std::unordered_map<int, std::function<void()>> actions{
+      {selected_map[Direction::up],
+       [&]() { cursor_row = std::max(0, cursor_row - 1); }},
+      {selected_map[Direction::down],
+       [&]() {
+         cursor_row =
+             std::min(board.height() - 1, cursor_row + 1);
+       }},
+      {selected_map[Direction::left],
+       [&]() { cursor_col = std::max(0, cursor_col - 1); }},
+      {selected_map[Direction::right],
+       [&]() {
+         cursor_col =
+             std::min(board.width() - 1, cursor_col + 1);
+       }},
+      {'d',
+       [&, changed = std::vector<int>()]() mutable {
+         bool safe = reveal_cell(board, cursor_row, cursor_col, changed);
+         dirty.insert(dirty.end(), changed.begin(), changed.end());
+         if (!safe) {
+           game_over = true;
+           mvprintw(board.height() + 2, 0,
+                    "Game over! Press 'r' to restart or 'q' to quit.");
+         }
+       }},
+      {'D',
+       [&, changed = std::vector<int>()]() mutable {
+         bool safe =
+             reveal_adjacent_cells(board, cursor_row, cursor_col, changed);
+         dirty.insert(dirty.end(), changed.begin(), changed.end());
+         if (!safe) {
+           game_over = true;
+           mvprintw(board.height() + 2, 0,
+                    "Game over! Press 'r' to restart or 'q' to quit.");
+         }
+       }},
+      {'f',
+       [&]() {
+         if (toggle_flag_cell(board, cursor_row, cursor_col)) {
+           dirty.push_back(board.index(cursor_row, cursor_col));
+         }
+       }},
+      {'F',
+       [&, changed = std::vector<int>()]() mutable {
+         flag_adjacent_cells(board, cursor_row, cursor_col, changed);
+         dirty.insert(dirty.end(), changed.begin(), changed.end());
+       }},
+      {'p',
+       [&]() {
+         // Hint: the unknown cell least likely to hold a mine, enumerating
+         // can take a while so it runs on a copy of the board
+         if (hint.valid()) {
+           return;
+         }
+         hint = std::async(std::launch::async, [snapshot = board] {
+           return mine_probabilities(snapshot, snapshot.mine_count());
+         });
+         mvprintw(board.height() + 3, 0, "Hint: thinking...");
+         clrtoeol();
+       }},
+      {'q', [&]() { game_over = true; }},
+      {'r', [&]() {
+         /* board = */
+         /*     std::vector<std::vector<Cell>>(height,
+          * std::vector<Cell>(width)); */
+         /* generate_board(board, mines_count); */
+         /* cursor_row = 0; */
+         /* cursor_col = 0; */
+         /* game_over = false; */
+       }}};
+
+  // Keys index the table directly, so a key press costs no hashing
+  ActionTable table;
+  for (auto &[key, action] : actions) {
+    if (key >= 0 && key < key_code_count) {
+      table[key] = std::move(action);
+    }
+  }
+  return table;
+}
+
+// Shows a finished hint by moving the cursor to the safest cell, unless it was
+// opened or flagged while the hint was computed
+static void apply_hint(const std::optional<MineProbabilities> &probabilities,
+                       const Board &board, int &cursor_row, int &cursor_col) {
+  if (probabilities.has_value() && probabilities->safest_cell != -1) {
+    int idx = probabilities->safest_cell;
+    if (!board[idx].is_revealed && !board[idx].is_flagged) {
+      cursor_row = board.row_of(idx);
+      cursor_col = board.col_of(idx);
+      mvprintw(board.height() + 3, 0, "Hint: %.1f%% chance of a mine",
+               100.0 * probabilities->of_cell[idx]);
+    } else {
+      mvprintw(board.height() + 3, 0, "Hint: the board changed, ask again");
+    }
+  } else {
+    mvprintw(board.height() + 3, 0, "Hint: no hint available");
+  }
+  clrtoeol();
+}
+
+bool handle_command_line_args(int argc, char *argv[], GameOptions &options,
+                              BenchOptions &bench) {
+  // Handle command-line arguments
+  bool early_return = false;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--width" && i + 1 < argc) {
+      options.width = std::stoi(argv[++i]);
+    } else if (arg == "--height" && i + 1 < argc) {
+      options.height = std::stoi(argv[++i]);
+    } else if (arg == "--mines" && i + 1 < argc) {
+      options.mines_count = std::stoi(argv[++i]);
+    } else if (arg == "--ng") {
+      options.no_guess = true;
+    } else if (arg == "--vim") {
+      options.vim = true;
+    } else if (arg == "--file" && i + 1 < argc) {
+      options.file_path = argv[++i];
+    } else if (arg == "--constructive") {
+      options.constructive = true;
+    } else if (arg == "--jobs" && i + 1 < argc) {
+      options.jobs = std::max(1, std::stoi(argv[++i]));
+    } else if (arg == "--seed" && i + 1 < argc) {
+      options.seed = std::stoull(argv[++i]);
+    } else if (arg == "--pool" && i + 1 < argc) {
+      options.pool_path = argv[++i];
+    } else if (arg == "--pool-size" && i + 1 < argc) {
+      options.pool_size = std::max(1, std::stoi(argv[++i]));
+    } else if (arg == "--min-3bv" && i + 1 < argc) {
+      options.min_bbbv = std::stoi(argv[++i]);
+    } else if (arg == "--max-3bv" && i + 1 < argc) {
+      options.max_bbbv = std::stoi(argv[++i]);
+    } else if (arg == "--validate" && i + 1 < argc) {
+      options.validate_path = argv[++i];
+    } else if (arg == "--bench" && i + 1 < argc) {
+      bench.boards = std::max(1, std::stoi(argv[++i]));
+    } else if (arg == "--format" && i + 1 < argc) {
+      std::string format = argv[++i];
+      if (format == "csv" || format == "json") {
+        bench.format = format;
+      } else {
+        std::cerr << "Unknown format: " << format << std::endl;
+        early_return = true;
+      }
+    } else if (arg == "--batch" && i + 1 < argc) {
+      bench.batch = std::max(1, std::stoi(argv[++i]));
+    } else if (arg == "--profile" && i + 1 < argc) {
+      bench.profile_path = argv[++i];
+    } else if (arg == "--backend" && i + 1 < argc) {
+      std::optional<EliminationBackend> backend = parse_backend(argv[++i]);
+      if (backend.has_value()) {
+        bench.backend = *backend;
+      } else {
+        std::cerr << "Unknown backend: " << argv[i] << std::endl;
+        early_return = true;
+      }
+    } else if (arg == "--help") {
+      display_help();
+      early_return = true;
+    } else {
+      std::cerr << "Unknown argument: " << arg << std::endl;
+      display_help();
+      early_return = true;
+    }
+  }
+  return early_return;
+}
+
+int start_game(int argc, char *argv[]) {
+
+  GameOptions options;
+  BenchOptions bench;
+
+  bool early_return = handle_command_line_args(argc, argv, options, bench);
+
+  if (early_return) {
+    return 0;
+  }
+
+  int width = options.width;
+  int height = options.height;
+  int mine_count = options.mines_count;
+  int jobs = options.jobs;
+  std::uint64_t seed = options.seed;
+
+  if (not options.validate_path.empty()) {
+    CorpusSummary summary =
+        validate_corpus(options.validate_path, std::cout, jobs, seed);
+    std::cerr << summary.solvable << " of " << summary.boards
+              << " boards are ngs, " << summary.errors << " could not be read"
+              << std::endl;
+    return summary.errors > 0 ? 1 : 0;
+  }
+
+  if (bench.boards > 0) {
+    return run_bench(bench, width, height, mine_count, options.file_path, jobs,
+                     seed);
+  }
+
+  Rng rng(seed);
+
+  Board board;
+
+  bool uses_file = not options.file_path.empty();
+
+  if (uses_file) {
+    auto pair = read_board_or_archive(options.file_path);
+    board = pair.first;
+    mine_count = pair.second;
+  } else {
+    board = generate_board(mine_count, height, width, rng);
+  }
+
+  // Declared out here so that its refill keeps running during the game
+  std::optional<BoardPool> pool;
+
+  if (options.no_guess) {
+    Solver solver(EliminationBackend::incremental, true, jobs, rng());
+
+    if (uses_file) {
+      // check if the board is ng solvable
+      BoardAnalysis analysis = analyze_board(board, mine_count, solver);
+      if (analysis.safe_start.has_value()) {
+        std::cout << "file board is ngs, hardest tier "
+                  << tier_name(analysis.hardest_tier) << std::endl;
+      } else {
+        std::cout << "file board is not ngs" << std::endl;
+      }
+      std::cout << "3BV " << analysis.metrics.bbbv << ", "
+                << analysis.metrics.openings << " openings" << std::endl;
+    } else {
+      BoardFilter accept;
+      if (options.min_bbbv > 0 || options.max_bbbv < INT_MAX) {
+        accept = [&](const BoardMetrics &metrics) {
+          return metrics.bbbv >= options.min_bbbv &&
+                 metrics.bbbv <= options.max_bbbv;
+        };
+      }
+
+      std::optional<NoGuessBoard> pooled;
+      if (not options.pool_path.empty()) {
+        pool.emplace(options.pool_path, options.pool_size);
+        pooled = pool->pop(width, height, mine_count, accept);
+      }
+
+      if (pooled.has_value()) {
+        board = std::move(pooled->board);
+      } else {
+        // keep trying until we genrate a ngsolvable board
+        std::cout << "generating a no guess board with " << jobs << " jobs"
+                  << std::endl;
+        GenerationMode mode = options.constructive
+                                  ? GenerationMode::constructive
+                                  : GenerationMode::reroll;
+        board = generate_no_guess_board(mine_count, height, width, jobs, mode,
+                                        seed, {}, accept)
+                    ->board;
+      }
+
+      // Top the pool up for the next game while this one is played
+      if (pool.has_value()) {
+        pool->refill(width, height, mine_count, rng());
+      }
+    }
+  }
+
+  initialize_ncurses();
+
+  int cursor_row = 0;
+  int cursor_col = 0;
+  bool game_over = false;
+  bool user_requested_quit;
+
+  // Cells changed since the last frame, only these and the cursor are redrawn
+  std::vector<int> dirty;
+  HintTask hint;
+
+  ActionTable action_map =
+      create_action_map(cursor_row, cursor_col, board, game_over, height,
+                        width, mine_count, options.vim, dirty, hint);
+
+  auto start_time = std::chrono::steady_clock::now();
+
+  // The timer is redrawn at most this often, keys are handled as they come
+  constexpr auto frame_interval = std::chrono::milliseconds(100);
+  auto next_frame = std::chrono::steady_clock::now();
+
+  display_board(board, cursor_row, cursor_col);
+
+  while (!game_over) {
+    // Sleep until a key arrives or the timer is due for its next frame
+    auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(
+        next_frame - std::chrono::steady_clock::now());
+    timeout(std::max<int>(0, wait.count()));
+    int ch = getch();
+
+    int previous_cursor_row = cursor_row;
+    int previous_cursor_col = cursor_col;
+
+    // Drain every pending key, a held arrow key then costs one frame
+    timeout(0);
+    for (; ch != ERR && !game_over; ch = getch()) {
+      if (ch >= 0 && ch < key_code_count && action_map[ch]) {
+        action_map[ch]();
+      }
+    }
+
+    if (hint.valid() && hint.wait_for(std::chrono::seconds(0)) ==
+                            std::future_status::ready) {
+      apply_hint(hint.get(), board, cursor_row, cursor_col);
+    }
+
+    if (field_clear(board)) {
+      game_over = true;
+      mvprintw(board.height() + 2, 0, "You won, well done");
+    }
+
+    display_dirty_cells(board, cursor_row, cursor_col, previous_cursor_row,
+                        previous_cursor_col, dirty);
+    auto now = std::chrono::steady_clock::now();
+    draw_timer(now - start_time);
+    refresh();
+    if (now >= next_frame) {
+      next_frame = now + frame_interval;
+    }
+  }
+
+  endwin();
+
+  if (field_clear(board)) {
+    std::cout << "Well done, you've won :)" << std::endl;
+  } else {
+    std::cout << "You hit a mine :(" << std::endl;
+  }
+
+  auto end_time = std::chrono::steady_clock::now();
+
+  // Calculate the elapsed time
+  auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+      end_time - start_time);
+
+  // Extract minutes, seconds, and milliseconds
+  auto minutes =
+      std::chrono::duration_cast<std::chrono::minutes>(duration).count();
+  duration -= std::chrono::minutes(minutes);
+  auto seconds =
+      std::chrono::duration_cast<std::chrono::seconds>(duration).count();
+  duration -= std::chrono::seconds(seconds);
+  auto milliseconds =
+      std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
+
+  // Output the elapsed time in minutes, seconds, and milliseconds
+  std::cout << "Game duration: " << minutes << " minutes, " << seconds
+            << " seconds, " << milliseconds << " milliseconds" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,170 @@
+#ifndef TUI_HPP
+#define TUI_HPP
+
+#include "game_logic.hpp"
+#include "probability.hpp"
+#include <array>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Define Direction enum class
+enum class Direction { up, down, left, right };
+
+/**
+ * @brief Initializes the ncurses environment and color pairs.
+ */
+void initialize_ncurses();
+
+/**
+ * @brief Gets the color pair for a specific number and cursor state.
+ *
+ * @param number The number on the cell (0-8) or special value for mine or flag.
+ * @param is_cursor Boolean flag indicating if the cell is under the cursor.
+ *
+ * @return The color pair number.
+ */
+int get_color_pair(int number, bool is_cursor);
+
+
+/**
+ * @brief Draws a single cell of the board at its place on the screen.
+ *
+ * @param board The Minesweeper board.
+ * @param row Row index of the cell.
+ * @param col Column index of the cell.
+ * @param is_cursor Boolean flag indicating if the cell is under the cursor.
+ */
+void draw_cell(const Board &board, int row, int col, bool is_cursor);
+
+/**
+ * @brief Draws the remaining mines counter above the board.
+ *
+ * @param remaining_mines The number of mines which are not flagged.
+ */
+void draw_mine_counter(int remaining_mines);
+
+/**
+ * @brief Draws the time played next to the mines counter.
+ *
+ * @param elapsed Time since the game started.
+ */
+void draw_timer(std::chrono::steady_clock::duration elapsed);
+
+/**
+ * @brief Displays the Minesweeper board with colored cells and cursor.
+ *
+ * @param board The Minesweeper board.
+ * @param cursor_row Current row of the cursor.
+ * @param cursor_col Current column of the cursor.
+ */
+void display_board(const Board &board, int cursor_row,
+                   int cursor_col); 
+
+/**
+ * @brief Redraws only what changed since the previous frame.
+ *
+ * Draws the cells in dirty, the cell the cursor left and the cell it is on,
+ * and the mine counter. Everything else on the screen is left as it is, and
+ * the counter comes from the board's O(1) count. Nothing is shown until the
+ * caller ends the frame with refresh(), so one frame can hold several keys.
+ *
+ * @param board The Minesweeper board.
+ * @param cursor_row Current row of the cursor.
+ * @param cursor_col Current column of the cursor.
+ * @param previous_cursor_row Row of the cursor in the previous frame.
+ * @param previous_cursor_col Column of the cursor in the previous frame.
+ * @param dirty Padded indices of the cells whose state changed, cleared once drawn.
+ */
+void display_dirty_cells(const Board &board, int cursor_row, int cursor_col,
+                         int previous_cursor_row, int previous_cursor_col,
+                         std::vector<int> &dirty);
+/**
+ * @brief Displays the help text for the command-line Minesweeper game.
+ */
+void display_help(); 
+using KeyMap = std::unordered_map<Direction, int>;
+
+/// Number of key codes getch() can return, KEY_MAX is 0777 in ncurses.
+constexpr int key_code_count = 512;
+
+/**
+ * @brief The action of each key code, empty for keys that do nothing.
+ */
+using ActionTable = std::array<std::function<void()>, key_code_count>;
+
+/**
+ * @brief A hint being computed off the input thread, see create_action_map().
+ */
+using HintTask = std::future<std::optional<MineProbabilities>>;
+
+/**
+ * @brief Creates the table of actions bound to the game state.
+ *
+ * The hint key copies the board and computes its mine probabilities on
+ * another thread, the game loop picks the result up from hint once it is
+ * ready. A hint key pressed while one is running is ignored.
+ *
+ * @return The actions, indexed by the key code getch() returns.
+ */
+ActionTable create_action_map(int &cursor_row, int &cursor_col,
+                              Board &board, bool &game_over,
+                              int height, int width, int mines_count, bool &vim,
+                              std::vector<int> &dirty, HintTask &hint);
+
+struct BenchOptions;
+
+/**
+ * @brief Settings of the game and of its board, see handle_command_line_args().
+ */
+struct GameOptions {
+  int width = 10;              ///< Number of columns of the board.
+  int height = 10;             ///< Number of rows of the board.
+  int mines_count = 10;        ///< Number of mines of the board.
+  bool no_guess = false;       ///< Play a no guess board.
+  bool vim = false;            ///< Move with the vim keys.
+  std::string file_path;       ///< Minefield to load instead of generating one, empty to generate.
+  int jobs = 1;                ///< Threads used to generate or check a no guess board.
+  bool constructive = false;   ///< Repair one board instead of regenerating it.
+  std::uint64_t seed = Rng::random_seed(); ///< Seed of the boards and of the solver.
+  std::string validate_path;   ///< Corpus to check instead of playing, empty to play.
+  std::string pool_path;       ///< Directory of the no guess board pool, empty for none.
+  int pool_size = 16;          ///< Boards of each size the pool keeps.
+  int min_bbbv = 0;            ///< Lowest 3BV of a generated no guess board.
+  int max_bbbv = INT_MAX;      ///< Highest 3BV of a generated no guess board.
+};
+
+/**
+ * @brief Handles command-line arguments for the Minesweeper game.
+ *
+ * Each flag sets one field of options or of bench, fields without a flag
+ * keep their defaults.
+ *
+ * @param argc The number of command-line arguments.
+ * @param argv The array of command-line arguments.
+ * @param options Reference to the game settings.
+ * @param bench Reference to the headless benchmark settings.
+ * @return `true` if an early return is required (e.g., when `--help` is invoked), otherwise `false`.
+ */
+bool handle_command_line_args(int argc, char *argv[], GameOptions &options,
+                              BenchOptions &bench);
+
+/**
+ * @brief Main function for the Minesweeper game.
+ *
+ * Handles command-line arguments and manages the game loop.
+ *
+ * @param argc Number of command-line arguments.
+ * @param argv Array of command-line arguments.
+ *
+ * @return Exit status code.
+ */
+int start_game(int argc, char *argv[]);
+
+#endif // TUI_HPP
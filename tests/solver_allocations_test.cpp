@@ -0,0 +1,68 @@
+// Checks that the deduction rounds of the incremental backend allocate
+// nothing once the solver's scratch buffers have grown. Enumeration still
+// allocates, see Solver::deduce_when_stuck(), so solves which reach it are
+// not checked.
+#include "allocation_counter.hpp"
+#include "solver.hpp"
+#include <iostream>
+#include <vector>
+
+int main() {
+  if (!allocation_counting_available()) {
+    std::cerr << "allocation_counting.cpp is not compiled in" << std::endl;
+    return 1;
+  }
+
+  const int mines_count = 40;
+  Rng rng(7);
+  Solver solver(EliminationBackend::incremental, false);
+
+  // Opened at the start solve() finds, so every attempt can be solved
+  std::vector<Board> opened;
+  for (int i = 0; i < 200; i++) {
+    Board board = generate_board(mines_count, 16, 16, rng);
+    std::optional<std::pair<int, int>> start = solver.solve(board, mines_count);
+    if (start.has_value()) {
+      reveal_cell(board, start->first, start->second);
+      opened.push_back(board);
+    }
+  }
+
+  // The first pass grows the buffers to what the largest board needs
+  std::vector<Board> boards = opened;
+  for (Board &board : boards) {
+    solver.solve_from_state(board, mines_count);
+  }
+
+  boards = opened;
+  long checked = 0;
+  long rounds = 0;
+  long mine_count_solves = 0;
+  int failures = 0;
+  for (std::size_t i = 0; i < boards.size(); i++) {
+    DeductionStats before = solver.deduction_stats();
+    long allocations_before = thread_allocation_count();
+    bool solved = solver.solve_from_state(boards[i], mines_count);
+    long allocations = thread_allocation_count() - allocations_before;
+    const DeductionStats &after = solver.deduction_stats();
+
+    // A solved board which enumerated nothing never reached enumeration
+    if (!solved || after.enumeration != before.enumeration) {
+      continue;
+    }
+    checked++;
+    rounds += solver.profile().rounds;
+    mine_count_solves += after.mine_count != before.mine_count;
+    if (allocations != 0) {
+      std::cerr << "board " << i << " allocated " << allocations
+                << " times in " << solver.profile().rounds << " rounds"
+                << std::endl;
+      failures++;
+    }
+  }
+
+  std::cout << checked << " solves, " << rounds << " rounds, "
+            << mine_count_solves << " used the mine count, " << failures
+            << " allocated" << std::endl;
+  return checked > 0 && mine_count_solves > 0 && failures == 0 ? 0 : 1;
+}